@@ -0,0 +1,203 @@
+// internal
+#include "aabb_batch.hpp"
+
+#include "cpu_features.hpp"
+
+void AabbBatch::clear()
+{
+	min_x.clear();
+	min_y.clear();
+	max_x.clear();
+	max_y.clear();
+	layer.clear();
+	mask.clear();
+}
+
+void AabbBatch::reserve(size_t n)
+{
+	min_x.reserve(n);
+	min_y.reserve(n);
+	max_x.reserve(n);
+	max_y.reserve(n);
+	layer.reserve(n);
+	mask.reserve(n);
+}
+
+void AabbBatch::push_back(vec2 min, vec2 max, uint32_t box_layer, uint32_t box_mask)
+{
+	min_x.push_back(min.x);
+	min_y.push_back(min.y);
+	max_x.push_back(max.x);
+	max_y.push_back(max.y);
+	layer.push_back(box_layer);
+	mask.push_back(box_mask);
+}
+
+// Tests count boxes, a multiple of the kernel's width, see batch_overlaps
+using OverlapKernel = uint32_t (*)(const AabbQuery&, const AabbBatch&, size_t, size_t, uint32_t&);
+
+// One box at a time
+static uint32_t overlaps_scalar(const AabbQuery& q, const AabbBatch& b, size_t begin, size_t count, uint32_t& accepted)
+{
+	uint32_t result = 0;
+	accepted = 0;
+	for (size_t k = 0; k < count; k++)
+	{
+		size_t i = begin + k;
+		if ((q.mask & b.layer[i]) == 0 || (b.mask[i] & q.layer) == 0)
+			continue;
+		accepted |= 1u << k;
+		if (q.min.x < b.max_x[i] && q.max.x > b.min_x[i] && q.min.y < b.max_y[i] && q.max.y > b.min_y[i])
+			result |= 1u << k;
+	}
+	return result;
+}
+
+#ifdef CPU_X86
+
+// 4 boxes per instruction
+KERNEL_TARGET("sse2")
+static uint32_t overlaps_sse2(const AabbQuery& q, const AabbBatch& b, size_t begin, size_t count, uint32_t& accepted)
+{
+	const __m128 q_min_x = _mm_set1_ps(q.min.x), q_min_y = _mm_set1_ps(q.min.y);
+	const __m128 q_max_x = _mm_set1_ps(q.max.x), q_max_y = _mm_set1_ps(q.max.y);
+	const __m128i q_layer = _mm_set1_epi32((int)q.layer), q_mask = _mm_set1_epi32((int)q.mask);
+	const __m128i zero = _mm_setzero_si128();
+	uint32_t result = 0;
+	accepted = 0;
+	for (size_t k = 0; k < count; k += 4)
+	{
+		size_t i = begin + k;
+		__m128 overlap_x = _mm_and_ps(_mm_cmplt_ps(q_min_x, _mm_loadu_ps(&b.max_x[i])), _mm_cmpgt_ps(q_max_x, _mm_loadu_ps(&b.min_x[i])));
+		__m128 overlap_y = _mm_and_ps(_mm_cmplt_ps(q_min_y, _mm_loadu_ps(&b.max_y[i])), _mm_cmpgt_ps(q_max_y, _mm_loadu_ps(&b.min_y[i])));
+		__m128i layer = _mm_loadu_si128((const __m128i*)&b.layer[i]);
+		__m128i mask = _mm_loadu_si128((const __m128i*)&b.mask[i]);
+		__m128i rejected = _mm_or_si128(_mm_cmpeq_epi32(_mm_and_si128(q_mask, layer), zero), _mm_cmpeq_epi32(_mm_and_si128(mask, q_layer), zero));
+		uint32_t lanes = ~(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(rejected)) & 0xf;
+		accepted |= lanes << k;
+		result |= ((uint32_t)_mm_movemask_ps(_mm_and_ps(overlap_x, overlap_y)) & lanes) << k;
+	}
+	return result;
+}
+
+// 8 boxes per instruction
+KERNEL_TARGET("avx2")
+static uint32_t overlaps_avx2(const AabbQuery& q, const AabbBatch& b, size_t begin, size_t count, uint32_t& accepted)
+{
+	const __m256 q_min_x = _mm256_set1_ps(q.min.x), q_min_y = _mm256_set1_ps(q.min.y);
+	const __m256 q_max_x = _mm256_set1_ps(q.max.x), q_max_y = _mm256_set1_ps(q.max.y);
+	const __m256i q_layer = _mm256_set1_epi32((int)q.layer), q_mask = _mm256_set1_epi32((int)q.mask);
+	const __m256i zero = _mm256_setzero_si256();
+	uint32_t result = 0;
+	accepted = 0;
+	for (size_t k = 0; k < count; k += 8)
+	{
+		size_t i = begin + k;
+		__m256 overlap_x = _mm256_and_ps(_mm256_cmp_ps(q_min_x, _mm256_loadu_ps(&b.max_x[i]), _CMP_LT_OQ), _mm256_cmp_ps(q_max_x, _mm256_loadu_ps(&b.min_x[i]), _CMP_GT_OQ));
+		__m256 overlap_y = _mm256_and_ps(_mm256_cmp_ps(q_min_y, _mm256_loadu_ps(&b.max_y[i]), _CMP_LT_OQ), _mm256_cmp_ps(q_max_y, _mm256_loadu_ps(&b.min_y[i]), _CMP_GT_OQ));
+		__m256i layer = _mm256_loadu_si256((const __m256i*)&b.layer[i]);
+		__m256i mask = _mm256_loadu_si256((const __m256i*)&b.mask[i]);
+		__m256i rejected = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(q_mask, layer), zero), _mm256_cmpeq_epi32(_mm256_and_si256(mask, q_layer), zero));
+		uint32_t lanes = ~(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(rejected)) & 0xff;
+		accepted |= lanes << k;
+		result |= ((uint32_t)_mm256_movemask_ps(_mm256_and_ps(overlap_x, overlap_y)) & lanes) << k;
+	}
+	return result;
+}
+
+// 16 boxes per instruction, the comparisons produce bit masks directly
+KERNEL_TARGET("avx512f")
+static uint32_t overlaps_avx512(const AabbQuery& q, const AabbBatch& b, size_t begin, size_t count, uint32_t& accepted)
+{
+	const __m512 q_min_x = _mm512_set1_ps(q.min.x), q_min_y = _mm512_set1_ps(q.min.y);
+	const __m512 q_max_x = _mm512_set1_ps(q.max.x), q_max_y = _mm512_set1_ps(q.max.y);
+	const __m512i q_layer = _mm512_set1_epi32((int)q.layer), q_mask = _mm512_set1_epi32((int)q.mask);
+	uint32_t result = 0;
+	accepted = 0;
+	for (size_t k = 0; k < count; k += 16)
+	{
+		size_t i = begin + k;
+		__mmask16 lanes = _mm512_test_epi32_mask(q_mask, _mm512_loadu_si512(&b.layer[i])) & _mm512_test_epi32_mask(_mm512_loadu_si512(&b.mask[i]), q_layer);
+		__mmask16 overlap = _mm512_mask_cmp_ps_mask(lanes, q_min_x, _mm512_loadu_ps(&b.max_x[i]), _CMP_LT_OQ);
+		overlap = _mm512_mask_cmp_ps_mask(overlap, q_max_x, _mm512_loadu_ps(&b.min_x[i]), _CMP_GT_OQ);
+		overlap = _mm512_mask_cmp_ps_mask(overlap, q_min_y, _mm512_loadu_ps(&b.max_y[i]), _CMP_LT_OQ);
+		overlap = _mm512_mask_cmp_ps_mask(overlap, q_max_y, _mm512_loadu_ps(&b.min_y[i]), _CMP_GT_OQ);
+		accepted |= (uint32_t)lanes << k;
+		result |= (uint32_t)overlap << k;
+	}
+	return result;
+}
+
+#endif
+
+struct KernelChoice
+{
+	const char* name;
+	size_t width;
+	OverlapKernel run;
+	bool supported;
+};
+
+// Widest first, the scalar kernel is last and always supported
+static KernelChoice KERNELS[] = {
+#ifdef CPU_X86
+	{ "avx512", 16, overlaps_avx512, false },
+	{ "avx2", 8, overlaps_avx2, false },
+	{ "sse2", 4, overlaps_sse2, false },
+#endif
+	{ "scalar", 1, overlaps_scalar, true },
+};
+const size_t KERNEL_COUNT = sizeof(KERNELS) / sizeof(KERNELS[0]);
+
+static size_t widest_kernel()
+{
+	size_t widest = KERNEL_COUNT - 1;
+	for (size_t i = KERNEL_COUNT; i-- > 0;)
+	{
+		KERNELS[i].supported = cpu_supports(KERNELS[i].name);
+		if (KERNELS[i].supported)
+			widest = i;
+	}
+	return widest;
+}
+
+static size_t current_kernel = widest_kernel();
+
+uint32_t batch_overlaps(const AabbQuery& query, const AabbBatch& batch, size_t begin, size_t count, uint32_t& accepted)
+{
+	// The widest kernel takes as many whole registers as fit and the narrower ones the rest. Leaving the scalar
+	// boxes to plain code keeps the wide kernels from running SSE code while their upper registers are in use.
+	uint32_t result = 0;
+	accepted = 0;
+	size_t done = 0;
+	for (size_t i = current_kernel; done < count; i++)
+	{
+		const KernelChoice& kernel = KERNELS[i];
+		size_t n = (count - done) / kernel.width * kernel.width;
+		if (!kernel.supported || n == 0)
+			continue;
+		uint32_t lanes;
+		result |= kernel.run(query, batch, begin + done, n, lanes) << done;
+		accepted |= lanes << done;
+		done += n;
+	}
+	return result;
+}
+
+const char* overlap_kernel_name()
+{
+	return KERNELS[current_kernel].name;
+}
+
+bool select_overlap_kernel(const std::string& name)
+{
+	for (size_t i = 0; i < KERNEL_COUNT; i++)
+	{
+		if (name == KERNELS[i].name && KERNELS[i].supported)
+		{
+			current_kernel = i;
+			return true;
+		}
+	}
+	return false;
+}
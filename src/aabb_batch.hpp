@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "common.hpp"
+
+// Axis-aligned boxes with their collision layer and mask, stored as one array per field so that one box
+// can be tested against several others per instruction
+struct AabbBatch
+{
+	std::vector<float> min_x, min_y, max_x, max_y;
+	std::vector<uint32_t> layer, mask;
+
+	void clear();
+	void reserve(size_t n);
+	void push_back(vec2 min, vec2 max, uint32_t layer, uint32_t mask);
+	size_t size() const { return min_x.size(); }
+};
+
+// A box tested against a batch
+struct AabbQuery
+{
+	vec2 min, max;
+	uint32_t layer, mask;
+};
+
+// The most boxes batch_overlaps tests in one call, one bit each of the results
+const size_t BATCH_OVERLAP_MAX = 32;
+
+// Tests the query against the boxes [begin, begin + count) of the batch, count is at most BATCH_OVERLAP_MAX.
+// Bit k of 'accepted' is set when box begin + k and the query accept each other's layer, and bit k of the result
+// when they also overlap. Runs the widest of the AVX-512, AVX2, SSE2 and scalar kernels that the CPU supports.
+uint32_t batch_overlaps(const AabbQuery& query, const AabbBatch& batch, size_t begin, size_t count, uint32_t& accepted);
+
+// Name of the kernel batch_overlaps runs: "avx512", "avx2", "sse2" or "scalar"
+const char* overlap_kernel_name();
+// Run a narrower kernel, e.g. to compare them, returns false when the CPU does not support it
+bool select_overlap_kernel(const std::string& name);
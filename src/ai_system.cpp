@@ -65,8 +65,8 @@ vec2 move(int row, int col) {
         int adjRow = row + dRow[i];
         int adjCol = col + dCol[i];
 
-        if (!(adjRow < 0 || adjCol < 0 || adjRow >= 80 || adjCol >= 160||grid[adjRow][adjCol] == 1 || grid[adjRow][adjCol] == 2||grid[adjRow][adjCol] == 3)) {
-            float flowValue = flowField[adjRow][adjCol];
+        if (grid.inside(adjRow, adjCol) && !grid.blocked(adjRow, adjCol)) {
+            float flowValue = flowField.get(adjRow, adjCol);
             
             // Avoid division by zero
             if (flowValue > 0.0f) {
@@ -82,8 +82,8 @@ vec2 move(int row, int col) {
             for (int j = 0; j < 8; ++j) {
                 int checkRow = row + dRow[j];
                 int checkCol = col + dCol[j];
-                if (!(checkRow < 0 || checkCol < 0 || checkRow >= 80 || checkCol >= 160||grid[checkRow][checkCol] == 1 || grid[checkRow][checkCol] == 2||grid[checkRow][checkCol] == 3)) {
-                    float currentFlow = flowField[checkRow][checkCol];
+                if (grid.inside(checkRow, checkCol) && !grid.blocked(checkRow, checkCol)) {
+                    float currentFlow = flowField.get(checkRow, checkCol);
                     if (currentFlow < minFlowValue) {
                         minFlowValue = currentFlow;
                         minDirection = directionVectors[j];
@@ -113,19 +113,12 @@ vec2 move(int row, int col) {
 void AISystem::step(float elapsed_ms)
 {
 
-	Motion* player_motion;
-    Player* player;
-    Wave* wave;
-    for (Entity entity : registry.waves.entities) {
-        wave = &registry.waves.get(entity);
-    }
-	for (Entity entity : registry.players.entities) {
-		player_motion = &registry.motions.get(entity);	
-        player = &registry.players.get(entity);
-	}
+	MotionRef player_motion = registry.motions.get(registry.single_entity<Player>());
+    Player* player = &registry.single<Player>();
+    Wave* wave = &registry.single<Wave>();
 
 	for (Entity entity : registry.boids.entities) {
-        Motion& motion = registry.motions.get(entity);
+        MotionRef motion = registry.motions.get(entity);
         
         vec2 position = {motion.position.x, motion.position.y};
         vec2 velocity = {0.f, 0.f};
@@ -143,7 +136,7 @@ void AISystem::step(float elapsed_ms)
 				continue;
 			}
 
-            Motion& other_motion = registry.motions.get(other);
+            MotionRef other_motion = registry.motions.get(other);
             vec2 other_position = {other_motion.position.x, other_motion.position.y};
             vec2 other_velocity = {other_motion.velocity.x, other_motion.velocity.y};
 
@@ -196,7 +189,7 @@ void AISystem::step(float elapsed_ms)
         
 		acceleration += move(startRow,startCol)* fmin(3.f * (cohesion_count+0.f), 50.f);
 
-        if (length(player_motion->position - position) < SEPARATION_DIST*2) {
+        if (length(player_motion.position - position) < SEPARATION_DIST*2) {
             acceleration += move(startRow,startCol) * 1000.f;
             acceleration += separation_force * 10.f;
         }
@@ -214,31 +207,31 @@ void AISystem::step(float elapsed_ms)
 
     std::vector<Entity> jokers_to_clone;
 	for (Entity entity : registry.deadlys.entities) { // root of decision tree
-		Motion& motion = registry.motions.get(entity);
+		MotionRef motion = registry.motions.get(entity);
 		Deadly& deadly = registry.deadlys.get(entity);
         if (deadly.enemy_type == ENEMIES::QUEEN_HEARTS) {
             const float healing_radius = 1000.0f;
             const float min_follow_distance = 200.0f;
 
-            Entity* closest_enemy = nullptr;
+            Entity closest_enemy = Entity::null();
             float min_dist = healing_radius;
 
-            for (Entity& enemy : registry.melees.entities) {
+            for (Entity enemy : registry.melees.entities) {
                 Deadly& heal_deadly = registry.deadlys.get(enemy);
-                Motion& enemy_motion = registry.motions.get(enemy);
+                MotionRef enemy_motion = registry.motions.get(enemy);
 
                 if (heal_deadly.enemy_type == ENEMIES::KING_CLUBS) { 
                     float dist = glm::distance(motion.position, enemy_motion.position);
 
                     if (dist < min_dist) { // level 1
                         min_dist = dist;
-                        closest_enemy = &enemy;
+                        closest_enemy = enemy;
                     }
                 }
             }
 
-            if (closest_enemy) {
-                Motion& target_motion = registry.motions.get(*closest_enemy);
+            if (Entity::valid(closest_enemy)) {
+                MotionRef target_motion = registry.motions.get(closest_enemy);
                 float dist_to_target = glm::distance(motion.position, target_motion.position);
 
 				if (dist_to_target > min_follow_distance) { // level 2
@@ -267,7 +260,7 @@ void AISystem::step(float elapsed_ms)
                     continue;
                 }
 
-                Motion& other_motion = registry.motions.get(other);
+                MotionRef other_motion = registry.motions.get(other);
                 vec2 other_position = { other_motion.position.x, other_motion.position.y };
 
                 float dist = length(other_position - motion.position);
@@ -293,8 +286,8 @@ void AISystem::step(float elapsed_ms)
                 motion.velocity = cap_velocity(motion.velocity + separation_force, 50);
 
             
-            if ((motion.position.x > player_motion->position.x && motion.scale.y < 0) ||
-                (motion.position.x < player_motion->position.x && motion.scale.y > 0)) {
+            if ((motion.position.x > player_motion.position.x && motion.scale.y < 0) ||
+                (motion.position.x < player_motion.position.x && motion.scale.y > 0)) {
                 motion.scale.y *= -1;
             }
             continue;
@@ -313,7 +306,7 @@ void AISystem::step(float elapsed_ms)
                     continue;
                 }
 
-                Motion& other_motion = registry.motions.get(other);
+                MotionRef other_motion = registry.motions.get(other);
                 vec2 other_position = { other_motion.position.x, other_motion.position.y };
 
                 float dist = length(other_position - motion.position);
@@ -339,8 +332,8 @@ void AISystem::step(float elapsed_ms)
                 motion.velocity = cap_velocity(motion.velocity + separation_force, 120);
 
             
-            if ((motion.position.x > player_motion->position.x && motion.scale.y < 0) ||
-                (motion.position.x < player_motion->position.x && motion.scale.y > 0)) {
+            if ((motion.position.x > player_motion.position.x && motion.scale.y < 0) ||
+                (motion.position.x < player_motion.position.x && motion.scale.y > 0)) {
                 motion.scale.y *= -1;
             }
         }
@@ -358,7 +351,7 @@ void AISystem::step(float elapsed_ms)
                     continue;
                 }
 
-                Motion& other_motion = registry.motions.get(other);
+                MotionRef other_motion = registry.motions.get(other);
                 vec2 other_position = { other_motion.position.x, other_motion.position.y };
 
                 float dist = length(other_position - motion.position);
@@ -387,11 +380,11 @@ void AISystem::step(float elapsed_ms)
             Joker& joker = registry.jokers.get(entity);
             joker.teleport_timer -= elapsed_ms;
             joker.clone_timer -= elapsed_ms;
-            float distanceToPlayer = length(player_motion->position - motion.position);
+            float distanceToPlayer = length(player_motion.position - motion.position);
 
             if (joker.teleport_timer <= 0 && distanceToPlayer < 300.0f) {
                 joker.teleport_timer = 3000.0f + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / 3000.0f)); // Random timer between 3-6 seconds
-                vec2 teleportPosition = findTeleportPosition(player_motion->position, motion.position, 300.f, 100.f);
+                vec2 teleportPosition = findTeleportPosition(player_motion.position, motion.position, 300.f, 100.f);
                 motion.position = teleportPosition;
 
                 joker_teleport = Mix_LoadWAV(audio_path("joker_teleport.wav").c_str());
@@ -410,8 +403,8 @@ void AISystem::step(float elapsed_ms)
             }
 
 
-            if ((motion.position.x > player_motion->position.x && motion.scale.x < 0) ||
-                (motion.position.x < player_motion->position.x && motion.scale.x > 0)) {
+            if ((motion.position.x > player_motion.position.x && motion.scale.x < 0) ||
+                (motion.position.x < player_motion.position.x && motion.scale.x > 0)) {
                 motion.scale.x *= -1;
             }
         }
@@ -429,7 +422,7 @@ void AISystem::step(float elapsed_ms)
                     continue;
                 }
 
-                Motion& other_motion = registry.motions.get(other);                
+                MotionRef other_motion = registry.motions.get(other);                
                 vec2 other_position = { other_motion.position.x, other_motion.position.y };
 
                 float dist = length(other_position - motion.position);
@@ -450,7 +443,7 @@ void AISystem::step(float elapsed_ms)
             int startRow = static_cast<int>(motion.position.y) / 12;
             int startCol = static_cast<int>(motion.position.x) / 12;
 
-            vec2 to_player = player_motion->position - motion.position;
+            vec2 to_player = player_motion.position - motion.position;
             float player_dist = length(to_player);
 
             vec2 genie_force = { 0.f, 0.f };
@@ -463,17 +456,14 @@ void AISystem::step(float elapsed_ms)
             motion.velocity *= 120;
             motion.velocity = cap_velocity(motion.velocity, 120);
                         
-            Wave* wave;
-            for (Entity entity : registry.waves.entities) {
-                wave = &registry.waves.get(entity);
-            }
+            Wave* wave = &registry.single<Wave>();
 
             Genie& genie = registry.genies.get(entity);
             genie.projectile_timer -= elapsed_ms;
             genie.teleport_timer -= elapsed_ms;
             if (genie.projectile_timer < 0 && player->health > 0) {
                 genie.projectile_timer = 1500.f;
-                createBoltProjectile(renderer, motion.position, player_motion->position, wave->wave_num);
+                createBoltProjectile(renderer, motion.position, player_motion.position, wave->wave_num);
 
                 genie_lightning_bolt = Mix_LoadWAV(audio_path("genie_lightning_bolt.wav").c_str());
                 Mix_PlayChannel(11, genie_lightning_bolt, 0);
@@ -481,20 +471,20 @@ void AISystem::step(float elapsed_ms)
 
             if (genie.teleport_timer < 0 && player->health > 0) {
                 genie.teleport_timer = 2000.f;
-                motion.position = findTeleportPosition(player_motion->position, motion.position, 400.f, 150.f);
+                motion.position = findTeleportPosition(player_motion.position, motion.position, 400.f, 150.f);
 
                 genie_teleport = Mix_LoadWAV(audio_path("genie_teleport.wav").c_str());
                 Mix_PlayChannel(10, genie_teleport, 0);
             } else if (player_dist > 600.f) {
                 genie.teleport_timer = 2000.f;
-                motion.position = findTeleportPosition(player_motion->position, motion.position, 400.f, 150.f);
+                motion.position = findTeleportPosition(player_motion.position, motion.position, 400.f, 150.f);
 
                 genie_teleport = Mix_LoadWAV(audio_path("genie_teleport.wav").c_str());
                 Mix_PlayChannel(10, genie_teleport, 0);
             }
                                               
-            if ((motion.position.x > player_motion->position.x && motion.scale.x < 0) ||
-                (motion.position.x < player_motion->position.x && motion.scale.x > 0)) {
+            if ((motion.position.x > player_motion.position.x && motion.scale.x < 0) ||
+                (motion.position.x < player_motion.position.x && motion.scale.x > 0)) {
                 motion.scale.x *= -1;
             }
         }
@@ -504,17 +494,15 @@ void AISystem::step(float elapsed_ms)
         cloneJoker(joker, original_joker.num_splits);
     }
 
-    for (Entity heart_entity : registry.healsEnemies.entities) {
-        Motion& heart_motion = registry.motions.get(heart_entity);
-        HealsEnemy& heart = registry.healsEnemies.get(heart_entity);
-        if (heart.target_entity != nullptr && registry.deadlys.has(*heart.target_entity)) {
-            Motion& deadly_motion = registry.motions.get(*heart.target_entity);
+    registry.view<HealsEnemy, Motion>().each([](Entity, HealsEnemy& heart, MotionRef heart_motion) {
+        if (registry.deadlys.has(heart.target_entity)) {
+            MotionRef deadly_motion = registry.motions.get(heart.target_entity);
             float angle = atan2(deadly_motion.position.x - heart_motion.position.x, deadly_motion.position.y - heart_motion.position.y);
             float heart_velocity_x = sin(angle) * 200;
             float heart_velocity_y = cos(angle) * 200;
             heart_motion.velocity = { heart_velocity_x, heart_velocity_y };
         }
-    }
+    });
 }
 
 vec2 AISystem::findTeleportPosition(vec2 playerPosition, vec2 enemyPosition, float teleportRadius, float bufferDistance) {
@@ -527,7 +515,7 @@ vec2 AISystem::findTeleportPosition(vec2 playerPosition, vec2 enemyPosition, flo
 
         int row = static_cast<int>(candidatePosition.y) / 12;
         int col = static_cast<int>(candidatePosition.x) / 12;
-        if (row >= 0 && col >= 0 && row < 80 && col < 160 && grid[row][col] == 0) {
+        if (grid.inside(row, col) && grid.get(row, col) == CELL_FLOOR) {
             return candidatePosition;
         }
     }
@@ -536,14 +524,11 @@ vec2 AISystem::findTeleportPosition(vec2 playerPosition, vec2 enemyPosition, flo
 }
 
 void AISystem::cloneJoker(Entity joker, int num_splits) {
-    Motion& original_motion = registry.motions.get(joker);
+    MotionRef original_motion = registry.motions.get(joker);
     Joker& original_joker = registry.jokers.get(joker);
     Deadly& original_deadly = registry.deadlys.get(joker);
 
-    Wave* wave;
-    for (Entity entity : registry.waves.entities) {
-        wave = &registry.waves.get(entity);
-    }
+    Wave* wave = &registry.single<Wave>();
 
     Entity new_joker = createJoker(renderer, original_motion.position, wave->wave_num);
 
@@ -0,0 +1,96 @@
+// internal
+#include "broadphase.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static size_t bit_count(uint32_t bits)
+{
+	size_t count = 0;
+	for (; bits != 0; bits &= bits - 1)
+		count++;
+	return count;
+}
+
+int Broadphase::cell_of(float coordinate) const
+{
+	return (int)std::floor(coordinate / cell_size);
+}
+
+void Broadphase::clear()
+{
+	boxes.clear();
+	entries.clear();
+	cells.clear();
+	batch.clear();
+}
+
+void Broadphase::insert(uint32_t id, vec2 min, vec2 max, uint32_t layer, uint32_t mask)
+{
+	// Boxes with a NaN coordinate never overlap anything, and boxes without a mask are never paired
+	if (!(min.x <= max.x && min.y <= max.y) || mask == 0)
+		return;
+	uint32_t box = (uint32_t)boxes.size();
+	boxes.push_back({ min, max, id, layer, mask });
+	for (int y = cell_of(min.y); y <= cell_of(max.y); y++)
+		for (int x = cell_of(min.x); x <= cell_of(max.x); x++)
+			entries.push_back({ key(x, y), box });
+}
+
+void Broadphase::build()
+{
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return a.cell != b.cell ? a.cell < b.cell : a.box < b.box;
+	});
+
+	// Copy the boxes in cell order, every cell becomes a range of the batch
+	batch.clear();
+	batch.reserve(entries.size());
+	for (const Entry& entry : entries)
+	{
+		const Box& box = boxes[entry.box];
+		batch.push_back(box.min, box.max, box.layer, box.mask);
+	}
+
+	cells.clear();
+	for (size_t begin = 0; begin < entries.size();)
+	{
+		size_t end = begin + 1;
+		while (end < entries.size() && entries[end].cell == entries[begin].cell)
+			end++;
+		cells.push_back({ (uint32_t)begin, (uint32_t)end });
+		begin = end;
+	}
+}
+
+void Broadphase::cell_pairs(size_t cell, std::vector<std::pair<uint32_t, uint32_t>>& out, Counts& counts) const
+{
+	size_t begin = cells[cell].first;
+	size_t end = cells[cell].second;
+	// Test every box of the cell against the later ones, a batch of up to BATCH_OVERLAP_MAX boxes at a time
+	for (size_t i = begin; i + 1 < end; i++)
+	{
+		const Box& a = boxes[entries[i].box];
+		AabbQuery query = { a.min, a.max, a.layer, a.mask };
+		for (size_t first = i + 1; first < end; first += BATCH_OVERLAP_MAX)
+		{
+			size_t count = std::min(end - first, BATCH_OVERLAP_MAX);
+			uint32_t accepted;
+			uint32_t overlaps = batch_overlaps(query, batch, first, count, accepted);
+			size_t accepted_count = bit_count(accepted);
+			counts.tests += accepted_count;
+			counts.filtered += count - accepted_count;
+
+			for (size_t k = 0; overlaps != 0; k++, overlaps >>= 1)
+			{
+				if ((overlaps & 1) == 0)
+					continue;
+				const Box& b = boxes[entries[first + k].box];
+				// Report the pair only in the cell of the top-left corner of the overlap
+				if (key(cell_of(std::max(a.min.x, b.min.x)), cell_of(std::max(a.min.y, b.min.y))) != entries[begin].cell)
+					continue;
+				out.push_back(a.id < b.id ? std::make_pair(a.id, b.id) : std::make_pair(b.id, a.id));
+			}
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "common.hpp"
+#include "aabb_batch.hpp"
+
+// Uniform grid broadphase: every axis-aligned box is binned into all grid cells it covers, and only boxes that share
+// a cell are tested against each other. The cells are found by sorting (cell, box) entries instead of hashing,
+// so rebuilding the grid every step allocates nothing once the vectors reached their working size.
+// A pair that shares several cells is only reported by the cell holding the top-left corner of the overlap.
+// Boxes carry a layer and a mask of layers, pairs are rejected on those before their boxes are compared.
+// The boxes of a cell are compared in batches with the SIMD kernels of aabb_batch.hpp.
+// After build() the cells are independent and may be queried from several threads at once.
+class Broadphase
+{
+public:
+	// Box-box tests and pairs rejected on their layers by a set of cell queries
+	struct Counts
+	{
+		size_t tests = 0;
+		size_t filtered = 0;
+	};
+
+	// The cell size should be about the size of the largest moving box, larger boxes just cover more cells
+	explicit Broadphase(float cell_size = 64.f) : cell_size(cell_size) {}
+
+	void clear();
+	// Add a box, 'id' is returned in the pairs, e.g. the row of the box in the Motion container.
+	// Two boxes are only paired when the mask of each one contains the layer of the other.
+	void insert(uint32_t id, vec2 min, vec2 max, uint32_t layer = ~0u, uint32_t mask = ~0u);
+
+	// Sort the boxes into their cells, the cell queries below need it
+	void build();
+	// Cells holding at least one box after build()
+	size_t cell_count() const { return cells.size(); }
+	// Appends the overlapping pairs reported by one cell to 'out' as (lower id, higher id), unsorted
+	void cell_pairs(size_t cell, std::vector<std::pair<uint32_t, uint32_t>>& out, Counts& counts) const;
+
+	size_t box_count() const { return boxes.size(); }
+
+private:
+	struct Box
+	{
+		vec2 min, max;
+		uint32_t id;
+		uint32_t layer, mask;
+	};
+	struct Entry
+	{
+		uint64_t cell;
+		uint32_t box;
+	};
+
+	float cell_size;
+	std::vector<Box> boxes;
+	std::vector<Entry> entries;
+	std::vector<std::pair<uint32_t, uint32_t>> cells; // range of the entries of every cell
+	AabbBatch batch; // the box of every entry, in cell order
+
+	int cell_of(float coordinate) const;
+	uint64_t key(int cell_x, int cell_y) const { return (uint64_t)(uint32_t)cell_y << 32 | (uint32_t)cell_x; }
+};
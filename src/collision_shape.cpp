@@ -0,0 +1,297 @@
+// internal
+#include "collision_shape.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// A hull becomes a circle when the circle around it is at most this much larger
+const float CIRCLE_FIT = 1.05f;
+
+static float cross(vec2 a, vec2 b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+CollisionShape shape_from_alpha(const unsigned char* rgba, int width, int height)
+{
+	CollisionShape shape;
+	int min_col = width, max_col = -1, min_row = height, max_row = -1;
+	for (int row = 0; row < height; row++)
+		for (int col = 0; col < width; col++)
+			if (rgba[((size_t)row * width + col) * 4 + 3] >= SHAPE_ALPHA_THRESHOLD)
+			{
+				min_col = std::min(min_col, col);
+				max_col = std::max(max_col, col);
+				min_row = std::min(min_row, row);
+				max_row = std::max(max_row, row);
+			}
+	if (max_col < 0)
+		return shape;
+
+	// Texel (row, col) covers [col, col + 1] / width - 0.5 of the quad, the first row is drawn at y = -0.5
+	shape.center = { (min_col + max_col + 1) / (2.f * width) - 0.5f, (min_row + max_row + 1) / (2.f * height) - 0.5f };
+	shape.half_size = { (max_col - min_col + 1) / (2.f * width), (max_row - min_row + 1) / (2.f * height) };
+
+	// The circle reaches the farthest corner of every opaque texel
+	float radius2 = 0;
+	for (int row = min_row; row <= max_row; row++)
+		for (int col = min_col; col <= max_col; col++)
+			if (rgba[((size_t)row * width + col) * 4 + 3] >= SHAPE_ALPHA_THRESHOLD)
+			{
+				float dx = std::max(std::abs((float)col / width - 0.5f - shape.center.x), std::abs((float)(col + 1) / width - 0.5f - shape.center.x));
+				float dy = std::max(std::abs((float)row / height - 0.5f - shape.center.y), std::abs((float)(row + 1) / height - 0.5f - shape.center.y));
+				radius2 = std::max(radius2, dx * dx + dy * dy);
+			}
+	shape.radius = std::sqrt(radius2);
+	if (M_PI * radius2 < 4.f * shape.half_size.x * shape.half_size.y)
+		shape.type = COLLIDER_SHAPE::CIRCLE;
+	return shape;
+}
+
+CollisionShape shape_from_points(const std::vector<vec2>& points)
+{
+	CollisionShape shape;
+	std::vector<vec2> sorted = points;
+	std::sort(sorted.begin(), sorted.end(), [](vec2 a, vec2 b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+	if (sorted.empty())
+		return shape;
+
+	vec2 min = sorted.front(), max = sorted.front();
+	for (vec2 p : sorted)
+	{
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	shape.center = (min + max) / 2.f;
+	shape.half_size = (max - min) / 2.f;
+
+	// Monotone chain, the lower hull left to right and the upper hull back, collinear points are dropped
+	std::vector<vec2> hull(2 * sorted.size());
+	size_t k = 0;
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		while (k >= 2 && cross(hull[k - 1] - hull[k - 2], sorted[i] - hull[k - 2]) <= 0)
+			k--;
+		hull[k++] = sorted[i];
+	}
+	for (size_t i = sorted.size() - 1, lower = k + 1; i-- > 0;)
+	{
+		while (k >= lower && cross(hull[k - 1] - hull[k - 2], sorted[i] - hull[k - 2]) <= 0)
+			k--;
+		hull[k++] = sorted[i];
+	}
+	hull.resize(k > 0 ? k - 1 : 0);
+	if (hull.size() < 3)
+		return shape;
+
+	float area = 0;
+	float radius2 = 0;
+	for (size_t i = 0; i < hull.size(); i++)
+	{
+		area += cross(hull[i], hull[(i + 1) % hull.size()]) / 2.f;
+		vec2 d = hull[i] - shape.center;
+		radius2 = std::max(radius2, dot(d, d));
+	}
+	shape.radius = std::sqrt(radius2);
+	float box_area = 4.f * shape.half_size.x * shape.half_size.y;
+	if (area >= box_area * 0.999f)
+		return shape;
+	if (M_PI * radius2 <= CIRCLE_FIT * area)
+	{
+		shape.type = COLLIDER_SHAPE::CIRCLE;
+		return shape;
+	}
+
+	shape.type = COLLIDER_SHAPE::POLYGON;
+	shape.vertices = hull;
+	// Parallel edges share their separating axis
+	for (size_t i = 0; i < hull.size(); i++)
+	{
+		vec2 edge = hull[(i + 1) % hull.size()] - hull[i];
+		bool parallel = false;
+		for (int other : shape.axis_edges)
+		{
+			vec2 other_edge = hull[(other + 1) % hull.size()] - hull[other];
+			if (std::abs(cross(edge, other_edge)) <= 1e-4f * length(edge) * length(other_edge))
+				parallel = true;
+		}
+		if (!parallel)
+			shape.axis_edges.push_back((int)i);
+	}
+	return shape;
+}
+
+void WorldShapes::clear()
+{
+	shapes.clear();
+	points.clear();
+	axes.clear();
+}
+
+// The corners were appended to 'points' from 'first_point' on
+size_t WorldShapes::add_polygon(Placed placed, size_t first_point, const int* edges, size_t edge_count)
+{
+	const vec2* corners = &points[first_point];
+	size_t corner_count = points.size() - first_point;
+	placed.first_point = (uint32_t)first_point;
+	placed.point_count = (uint32_t)corner_count;
+	placed.first_axis = (uint32_t)axes.size();
+	placed.min = placed.max = corners[0];
+	for (size_t i = 1; i < corner_count; i++)
+	{
+		placed.min = glm::min(placed.min, corners[i]);
+		placed.max = glm::max(placed.max, corners[i]);
+	}
+	for (size_t i = 0; i < edge_count; i++)
+	{
+		vec2 edge = corners[(edges[i] + 1) % corner_count] - corners[edges[i]];
+		float edge_length = length(edge);
+		// A shape scaled to nothing along one side has no axis there
+		if (edge_length > 0)
+			axes.push_back(vec2(-edge.y, edge.x) / edge_length);
+	}
+	placed.axis_count = (uint32_t)axes.size() - placed.first_axis;
+	shapes.push_back(placed);
+	return shapes.size() - 1;
+}
+
+size_t WorldShapes::add_box(vec2 center, vec2 half_size)
+{
+	static const int BOX_EDGES[] = { 0, 1 };
+	Placed placed;
+	placed.axis_aligned = true;
+	placed.center = center;
+	size_t first_point = points.size();
+	points.push_back(center - half_size);
+	points.push_back({ center.x + half_size.x, center.y - half_size.y });
+	points.push_back(center + half_size);
+	points.push_back({ center.x - half_size.x, center.y + half_size.y });
+	return add_polygon(placed, first_point, BOX_EDGES, 2);
+}
+
+size_t WorldShapes::add(const CollisionShape& shape, const MotionRef& motion)
+{
+	static const int BOX_EDGES[] = { 0, 1 };
+	// The transform of the sprite: scale, then rotate, then translate (see Transform)
+	float c = std::cos(motion.angle);
+	float s = std::sin(motion.angle);
+	auto to_world = [&](vec2 local) {
+		vec2 scaled = local * motion.scale;
+		return motion.position + vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y);
+	};
+
+	Placed placed;
+	placed.center = to_world(shape.center);
+	vec2 abs_scale = { std::abs(motion.scale.x), std::abs(motion.scale.y) };
+	// A circle stretched into an ellipse is approximated by its box
+	vec2 half_size = shape.half_size;
+	if (shape.type == COLLIDER_SHAPE::CIRCLE)
+	{
+		if (abs_scale.x == abs_scale.y)
+		{
+			placed.circle = true;
+			placed.radius = shape.radius * abs_scale.x;
+			placed.min = placed.center - placed.radius;
+			placed.max = placed.center + placed.radius;
+			shapes.push_back(placed);
+			return shapes.size() - 1;
+		}
+		half_size = vec2(shape.radius);
+	}
+
+	if (shape.type != COLLIDER_SHAPE::POLYGON)
+	{
+		if (motion.angle == 0)
+			return add_box(placed.center, half_size * abs_scale);
+		size_t first_point = points.size();
+		points.push_back(to_world(shape.center - half_size));
+		points.push_back(to_world({ shape.center.x + half_size.x, shape.center.y - half_size.y }));
+		points.push_back(to_world(shape.center + half_size));
+		points.push_back(to_world({ shape.center.x - half_size.x, shape.center.y + half_size.y }));
+		return add_polygon(placed, first_point, BOX_EDGES, 2);
+	}
+
+	size_t first_point = points.size();
+	for (vec2 vertex : shape.vertices)
+		points.push_back(to_world(vertex));
+	return add_polygon(placed, first_point, shape.axis_edges.data(), shape.axis_edges.size());
+}
+
+static void project(const vec2* points, uint32_t count, vec2 axis, float& low, float& high)
+{
+	low = high = dot(points[0], axis);
+	for (uint32_t i = 1; i < count; i++)
+	{
+		float d = dot(points[i], axis);
+		low = std::min(low, d);
+		high = std::max(high, d);
+	}
+}
+
+// Projects both shapes on the axes of 'owner', one of them
+bool WorldShapes::separated_on_axes(const Placed& owner, const Placed& a, const Placed& b) const
+{
+	for (uint32_t i = 0; i < owner.axis_count; i++)
+	{
+		vec2 axis = axes[owner.first_axis + i];
+		float a_low, a_high, b_low, b_high;
+		if (a.circle)
+		{
+			a_low = dot(a.center, axis) - a.radius;
+			a_high = a_low + 2.f * a.radius;
+		}
+		else
+			project(&points[a.first_point], a.point_count, axis, a_low, a_high);
+		if (b.circle)
+		{
+			b_low = dot(b.center, axis) - b.radius;
+			b_high = b_low + 2.f * b.radius;
+		}
+		else
+			project(&points[b.first_point], b.point_count, axis, b_low, b_high);
+		if (a_high <= b_low || b_high <= a_low)
+			return true;
+	}
+	return false;
+}
+
+bool WorldShapes::overlap(size_t a_index, size_t b_index) const
+{
+	const Placed& a = shapes[a_index];
+	const Placed& b = shapes[b_index];
+	if (!(a.min.x < b.max.x && a.max.x > b.min.x && a.min.y < b.max.y && a.max.y > b.min.y))
+		return false;
+	// Two boxes that are their own bounds overlap when the bounds do
+	if (a.axis_aligned && b.axis_aligned)
+		return true;
+	if (a.circle && b.circle)
+	{
+		vec2 d = a.center - b.center;
+		return dot(d, d) < (a.radius + b.radius) * (a.radius + b.radius);
+	}
+	if (a.circle || b.circle)
+	{
+		const Placed& circle = a.circle ? a : b;
+		const Placed& polygon = a.circle ? b : a;
+		if (separated_on_axes(polygon, polygon, circle))
+			return false;
+		// The last axis runs from the circle center to the closest vertex of the polygon
+		vec2 closest = points[polygon.first_point];
+		for (uint32_t i = 1; i < polygon.point_count; i++)
+		{
+			vec2 p = points[polygon.first_point + i];
+			if (dot(p - circle.center, p - circle.center) < dot(closest - circle.center, closest - circle.center))
+				closest = p;
+		}
+		vec2 d = closest - circle.center;
+		if (dot(d, d) == 0)
+			return true;
+		vec2 axis = d / std::sqrt(dot(d, d));
+		float low, high;
+		project(&points[polygon.first_point], polygon.point_count, axis, low, high);
+		float center = dot(circle.center, axis);
+		return !(high <= center - circle.radius || center + circle.radius <= low);
+	}
+	return !separated_on_axes(a, a, b) && !separated_on_axes(b, a, b);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "common.hpp"
+#include "components.hpp"
+
+// Alpha from which a texel is part of the sprite
+const unsigned char SHAPE_ALPHA_THRESHOLD = 128;
+
+// The box around the opaque texels of an RGBA image, or the circle around them when it is smaller.
+// A fully transparent image keeps the whole quad.
+CollisionShape shape_from_alpha(const unsigned char* rgba, int width, int height);
+
+// The convex hull of the points, as a box when it is one and as the circle around it when that is nearly as tight
+CollisionShape shape_from_points(const std::vector<vec2>& points);
+
+// The collision shapes of one physics step placed in the world. The vertices and separating axes of a shape are
+// transformed once when it is added, testing a pair only projects them.
+class WorldShapes
+{
+public:
+	void clear();
+	// Places the shape where the entity is drawn, with its position, angle and scale, and returns its index
+	size_t add(const CollisionShape& shape, const MotionRef& motion);
+	// Places an axis-aligned box, e.g. the Motion box of an entity without a Collider
+	size_t add_box(vec2 center, vec2 half_size);
+
+	vec2 min(size_t shape) const { return shapes[shape].min; }
+	vec2 max(size_t shape) const { return shapes[shape].max; }
+	size_t size() const { return shapes.size(); }
+
+	// Separating axis test, shapes that only touch do not overlap
+	bool overlap(size_t a, size_t b) const;
+
+private:
+	struct Placed
+	{
+		bool circle = false;
+		bool axis_aligned = false; // a box that is its own bounds
+		vec2 center = { 0, 0 };
+		float radius = 0;
+		vec2 min = { 0, 0 };
+		vec2 max = { 0, 0 };
+		uint32_t first_point = 0, point_count = 0;
+		uint32_t first_axis = 0, axis_count = 0;
+	};
+	std::vector<Placed> shapes;
+	std::vector<vec2> points;
+	std::vector<vec2> axes;
+
+	size_t add_polygon(Placed placed, size_t first_point, const int* edges, size_t edge_count);
+	bool separated_on_axes(const Placed& owner, const Placed& a, const Placed& b) const;
+};
@@ -32,6 +32,10 @@ inline std::string mesh_path(const std::string& name) {return data_path() + "/me
 const int window_width_px = 1280;
 const int window_height_px = 720;
 
+// The length of the rendered frame that per-frame rates (decays, animation steps) were tuned for,
+// systems stepped at the fixed tick scale them by elapsed_ms / FRAME_MS
+const float FRAME_MS = 16.67f;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
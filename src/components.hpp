@@ -109,13 +109,13 @@ struct Melee
 struct HealsEnemy
 {
 	float health = 0;
-	void* last_touched = nullptr;
-	Entity* target_entity;
+	Entity last_touched = Entity::null();
+	Entity target_entity = Entity::null();
 };
 
 struct Bolt {
 	float damage = 0;
-	void* last_touched = nullptr;
+	Entity last_touched = Entity::null();
 };
 
 struct Healer
@@ -171,7 +171,7 @@ struct KillsEnemy {
 	unsigned int pierce_left = 0;
 	unsigned int bounce_left = 0;
 	PROJECTILE type;
-	void* last_touched = nullptr;
+	Entity last_touched = Entity::null();
 	std::string name = "";
 };
 
@@ -196,12 +196,204 @@ struct Motion {
 	vec2 scale = { 10, 10 };
 };
 
-// Stucture to store collision information
-struct Collision
+// The Motion of one entity in the column storage of registry.motions, see ComponentContainer<Motion> below.
+// Its fields refer to the columns, so it reads and writes like a Motion&, and it converts to a Motion copy.
+struct MotionRef
 {
-	// Note, the first object is stored in the ECS container.entities
-	Entity other; // the second object involved in the collision
-	Collision(Entity& other) { this->other = other; };
+	vec2& position;
+	float& angle;
+	vec2& previous_position;
+	vec2& velocity;
+	vec2& scale;
+
+	MotionRef(vec2& position, float& angle, vec2& previous_position, vec2& velocity, vec2& scale)
+		: position(position), angle(angle), previous_position(previous_position), velocity(velocity), scale(scale) {}
+	// Refers to a Motion outside of the registry
+	MotionRef(Motion& motion)
+		: MotionRef(motion.position, motion.angle, motion.previous_position, motion.velocity, motion.scale) {}
+	MotionRef(const MotionRef&) = default;
+
+	operator Motion() const { return { position, angle, previous_position, velocity, scale }; }
+	MotionRef& operator=(const Motion& motion)
+	{
+		position = motion.position;
+		angle = motion.angle;
+		previous_position = motion.previous_position;
+		velocity = motion.velocity;
+		scale = motion.scale;
+		return *this;
+	}
+};
+
+// Motion is stored as one column per field instead of an array of structs, so passes over every moving entity,
+// like the position prediction in PhysicsSystem::step, stream through contiguous position and velocity arrays.
+// Row i of every column belongs to entities[i]. get() hands out a MotionRef into the columns.
+// The columns use their own allocators, the ComponentAllocator trait does not apply to Motion.
+template <typename Allocator>
+class ComponentContainer<Motion, false, Allocator> : public SparseSet
+{
+public:
+	AlignedVector<vec2> position;
+	AlignedVector<vec2> velocity;
+	std::vector<float> angle;
+	std::vector<vec2> previous_position;
+	std::vector<vec2> scale;
+
+	MotionRef insert(Entity e, Motion c, bool check_for_duplicates = true)
+	{
+		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+
+		size_t capacity = position.capacity();
+		push_row(e);
+		position.push_back(c.position);
+		velocity.push_back(c.velocity);
+		angle.push_back(c.angle);
+		previous_position.push_back(c.previous_position);
+		scale.push_back(c.scale);
+		if (position.capacity() != capacity)
+			growths++;
+		set_signature_bit(e);
+		return at(entities.size() - 1);
+	}
+
+	template<typename... Args>
+	MotionRef emplace(Entity e, Args &&... args) {
+		return insert(e, Motion(std::forward<Args>(args)...));
+	};
+	template<typename... Args>
+	MotionRef emplace_with_duplicates(Entity e, Args &&... args) {
+		return insert(e, Motion(std::forward<Args>(args)...), false);
+	};
+
+	MotionRef get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return at(dense_index(e));
+	}
+	// The Motion of a row, e.g. to walk the columns and entities together
+	MotionRef at(size_t row) {
+		return { position[row], angle[row], previous_position[row], velocity[row], scale[row] };
+	}
+	// The row of e in the columns, e must have a Motion
+	size_t row(Entity e) const {
+		return dense_index(e);
+	}
+
+	// Modify the Motion of e through fn(MotionRef) and record the change for systems that track it
+	template <typename Fn>
+	void patch(Entity e, Fn fn)
+	{
+		fn(get(e));
+		mark_modified(e);
+	}
+
+	void remove(Entity e)
+	{
+		if (has(e))
+		{
+			unsigned int row = dense_index(e);
+			move_last(position, row);
+			move_last(velocity, row);
+			move_last(angle, row);
+			move_last(previous_position, row);
+			move_last(scale, row);
+			remove_row(e, row);
+		}
+	}
+
+	void clear()
+	{
+		clear_rows();
+		position.clear();
+		velocity.clear();
+		angle.clear();
+		previous_position.clear();
+		scale.clear();
+	}
+
+	void reserve(size_t n)
+	{
+		reserve_rows(n);
+		position.reserve(n);
+		velocity.reserve(n);
+		angle.reserve(n);
+		previous_position.reserve(n);
+		scale.reserve(n);
+	}
+
+	template <class Compare>
+	void sort(Compare comparisonFunction)
+	{
+		sort_rows(comparisonFunction, [this](unsigned int a, unsigned int b) {
+			std::swap(position[a], position[b]);
+			std::swap(velocity[a], velocity[b]);
+			std::swap(angle[a], angle[b]);
+			std::swap(previous_position[a], previous_position[b]);
+			std::swap(scale[a], scale[b]);
+		});
+	}
+
+private:
+	template <typename Column>
+	static void move_last(Column& column, unsigned int row)
+	{
+		column[row] = column.back();
+		column.pop_back();
+	}
+};
+
+// Collision layers, every collider is on one layer
+enum COLLISION_LAYER : uint32_t {
+	LAYER_PLAYER = 1 << 0,
+	LAYER_ENEMY = 1 << 1,
+	LAYER_PLAYER_PROJECTILE = 1 << 2,
+	LAYER_ENEMY_PROJECTILE = 1 << 3,
+	LAYER_PICKUP = 1 << 4,
+	LAYER_STATIC = 1 << 5,
+	LAYER_UI = 1 << 6
+};
+const int COLLISION_LAYER_COUNT = 7;
+
+// A pair of overlapping entities found by the physics system, see ContactBuffer.
+// The layers are the bit positions of each side's COLLISION_LAYER, COLLISION_LAYER_COUNT for colliders without a filter.
+struct Contact
+{
+	Entity a;
+	Entity b;
+	uint8_t layer_a = COLLISION_LAYER_COUNT;
+	uint8_t layer_b = COLLISION_LAYER_COUNT;
+};
+
+// The layer of a collider and the layers it collides with. A pair of entities is only tested when the mask of
+// each one contains the layer of the other. Entities without a filter collide with everything.
+struct CollisionFilter
+{
+	uint32_t layer = ~0u;
+	uint32_t mask = ~0u;
+	bool accepts(const CollisionFilter& other) const { return (mask & other.layer) != 0 && (other.mask & layer) != 0; }
+};
+
+enum class COLLIDER_SHAPE {
+	AABB,
+	CIRCLE,
+	POLYGON
+};
+
+// The outline of a texture or mesh in its local space, where a sprite spans [-0.5, 0.5] on both axes.
+// Computed once when the asset is loaded, see collision_shape.hpp.
+struct CollisionShape
+{
+	COLLIDER_SHAPE type = COLLIDER_SHAPE::AABB;
+	vec2 center = { 0, 0 }; // of the box and the circle
+	vec2 half_size = { 0.5f, 0.5f }; // of the box
+	float radius = 0.5f; // of the circle
+	std::vector<vec2> vertices; // of the polygon, convex and counterclockwise
+	std::vector<int> axis_edges; // edges of the polygon whose normals are separating axes, one per direction
+};
+
+// The shape an entity collides with, placed with its Motion. Entities without one collide with their Motion box.
+struct Collider
+{
+	const CollisionShape* shape = nullptr;
 };
 
 // Data structure for toggling debug mode
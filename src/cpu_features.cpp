@@ -0,0 +1,43 @@
+// internal
+#include "cpu_features.hpp"
+
+#ifdef CPU_X86
+
+bool cpu_supports(const std::string& name)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if (name == "avx512")
+		return __builtin_cpu_supports("avx512f");
+	if (name == "avx2")
+		return __builtin_cpu_supports("avx2");
+	if (name == "avx")
+		return __builtin_cpu_supports("avx");
+	return name == "sse2" ? __builtin_cpu_supports("sse2") : name == "scalar";
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	unsigned long long xcr0 = (info[2] & (1 << 27)) != 0 ? _xgetbv(0) : 0; // registers the OS saves
+	__cpuidex(info, 7, 0);
+	if (name == "avx512")
+		return (info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6;
+	if (name == "avx2")
+		return (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+	if (name == "avx")
+		return avx && (xcr0 & 0x6) == 0x6;
+	return name == "sse2" ? sse2 : name == "scalar";
+#else
+	return name == "scalar";
+#endif
+}
+
+#else
+
+bool cpu_supports(const std::string& name)
+{
+	return name == "scalar";
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit the instructions of a kernel for the functions marked with its target,
+// MSVC emits any intrinsic. Only call such a function after cpu_supports() accepted its instruction set.
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+// Whether the CPU and the operating system support the instructions of a kernel:
+// "avx512", "avx2", "avx", "sse2" or "scalar", which is always supported
+bool cpu_supports(const std::string& name);
@@ -0,0 +1,153 @@
+// internal
+#include "flow_field.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// The 8 neighbours of a cell and the cost of the step, diagonals cost about sqrt(2) times more
+const int ROW_STEPS[] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+const int COL_STEPS[] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const uint32_t STEP_COSTS[] = { 10, 14, 10, 14, 10, 14, 10, 14 };
+
+static uint32_t pack(int row, int col)
+{
+	return (uint32_t)row << 16 | (uint32_t)col;
+}
+
+void FlowFieldUpdater::reset_stats()
+{
+	update_stats = Stats();
+}
+
+void FlowFieldUpdater::seed(int row, int col)
+{
+	if (!level.chunk(row, col))
+		return;
+	flowField.set(row, col, 0);
+	buckets[0].push_back(pack(row, col));
+	touched++;
+}
+
+void FlowFieldUpdater::relax(int row_min, int col_min, int row_max, int col_max)
+{
+	size_t queued = 0;
+	for (const auto& bucket : buckets)
+		queued += bucket.size();
+	for (uint32_t distance = 0; queued > 0; distance++)
+	{
+		// A step never queues into the bucket being read
+		std::vector<uint32_t>& bucket = buckets[distance % BUCKETS];
+		for (size_t i = 0; i < bucket.size(); i++)
+		{
+			int row = (int)(bucket[i] >> 16);
+			int col = (int)(bucket[i] & 0xffff);
+			// Queued again at a lower distance since
+			if (flowField.get(row, col) != distance)
+				continue;
+			for (int k = 0; k < 8; k++)
+			{
+				int adj_row = row + ROW_STEPS[k];
+				int adj_col = col + COL_STEPS[k];
+				if (adj_row < row_min || adj_row > row_max || adj_col < col_min || adj_col > col_max || grid.blocked(adj_row, adj_col))
+					continue;
+				uint32_t adj_distance = distance + STEP_COSTS[k];
+				if (adj_distance >= flowField.get(adj_row, adj_col))
+					continue;
+				flowField.set(adj_row, adj_col, (uint16_t)adj_distance);
+				buckets[adj_distance % BUCKETS].push_back(pack(adj_row, adj_col));
+				queued++;
+				touched++;
+			}
+		}
+		queued -= bucket.size();
+		bucket.clear();
+	}
+}
+
+void FlowFieldUpdater::rebuild(int row, int col)
+{
+	flowField.set_outer_offset(0, 0, -1, -1, 0);
+	flowField.fill(FLOW_UNREACHED);
+	touched = level.allocated_chunks() * CHUNK_SIZE * CHUNK_SIZE;
+	seed(row, col);
+	seed(row, col - 1);
+	relax(0, 0, level.height() - 1, level.width() - 1);
+
+	anchor_row = row;
+	anchor_col = col;
+	window_row_min = std::max(row - WINDOW_RADIUS, 0);
+	window_row_max = std::min(row + WINDOW_RADIUS, level.height() - 1);
+	window_col_min = std::max(col - 1 - WINDOW_RADIUS, 0);
+	window_col_max = std::min(col + WINDOW_RADIUS, level.width() - 1);
+	anchor_distances.clear();
+	for (int r = window_row_min; r <= window_row_max; r++)
+		for (int c = window_col_min; c <= window_col_max; c++)
+			anchor_distances.push_back(flowField.get(r, c));
+
+	update_stats.rebuilds++;
+	update_stats.cells_touched += touched;
+	update_stats.last_touched = touched;
+}
+
+uint16_t FlowFieldUpdater::anchor_distance(int row, int col) const
+{
+	if (row < window_row_min || row > window_row_max || col < window_col_min || col > window_col_max)
+		return FLOW_UNREACHED;
+	return anchor_distances[(size_t)(row - window_row_min) * (window_col_max - window_col_min + 1) + (col - window_col_min)];
+}
+
+bool FlowFieldUpdater::descends(int row, int col) const
+{
+	uint16_t distance = flowField.get(row, col);
+	if (distance == 0 || distance == FLOW_UNREACHED)
+		return true;
+	for (int k = 0; k < 8; k++)
+		if (flowField.get(row + ROW_STEPS[k], col + COL_STEPS[k]) < distance)
+			return true;
+	return false;
+}
+
+void FlowFieldUpdater::move_goal(int row, int col)
+{
+	if (anchor_row < 0 || std::abs(row - anchor_row) > REPAIR_RANGE || std::abs(col - anchor_col) > REPAIR_RANGE)
+	{
+		rebuild(row, col);
+		return;
+	}
+	// A cell reads its distance to the nearer of the two anchor cells, the other one may be a step further from the goal
+	uint16_t to_goal = std::min(anchor_distance(row, col), anchor_distance(row, col - 1));
+	if (to_goal == FLOW_UNREACHED)
+	{
+		rebuild(row, col);
+		return;
+	}
+	to_goal += STEP_COSTS[0];
+
+	// The window starts from the same bounds as the cells around it
+	touched = 0;
+	size_t i = 0;
+	for (int r = window_row_min; r <= window_row_max; r++)
+		for (int c = window_col_min; c <= window_col_max; c++, i++)
+		{
+			uint16_t distance = anchor_distances[i];
+			if (distance != FLOW_UNREACHED)
+				distance = (uint16_t)std::min<uint32_t>(distance + to_goal, FLOW_UNREACHED - 1);
+			flowField.set(r, c, distance);
+			touched++;
+		}
+	flowField.set_outer_offset(window_row_min, window_col_min, window_row_max, window_col_max, to_goal);
+	seed(row, col);
+	seed(row, col - 1);
+	relax(window_row_min, window_col_min, window_row_max, window_col_max);
+
+	// The anchor only leads on when the goal is reached from it inside the window, otherwise it would stop enemies
+	if (!descends(anchor_row, anchor_col) || !descends(anchor_row, anchor_col - 1))
+	{
+		update_stats.cells_touched += touched;
+		rebuild(row, col);
+		return;
+	}
+	update_stats.repairs++;
+	update_stats.cells_touched += touched;
+	update_stats.last_touched = touched;
+}
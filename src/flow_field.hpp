@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "grid.hpp"
+
+// Keeps flowField leading to the goal, the player cell and the cell to its left. A rebuild runs Dijkstra over the
+// whole level and makes the goal the anchor. While the goal stays within REPAIR_RANGE cells of the anchor, a move
+// only repairs the window of WINDOW_RADIUS cells around the anchor: every cell outside the window keeps its distance
+// to the anchor and reads it plus the distance from the anchor to the goal, which bounds its distance to the goal,
+// and the window is relaxed from the new goal down from those same bounds. Every reached cell but the goal keeps a
+// neighbour that is closer, so enemies never stop short of the player.
+class FlowFieldUpdater
+{
+public:
+	static const int WINDOW_RADIUS = 16;
+	static const int REPAIR_RANGE = 8;
+
+	// Rebuilds the field for a goal cell, e.g. after the walls changed
+	void rebuild(int row, int col);
+	// Leads the field to a new goal cell, repairing it when the goal is close to the anchor
+	void move_goal(int row, int col);
+
+	// Updates and field cells written since the last reset_stats
+	struct Stats
+	{
+		size_t rebuilds = 0;
+		size_t repairs = 0;
+		size_t cells_touched = 0;
+		size_t last_touched = 0; // by the last update
+	};
+	const Stats& stats() const { return update_stats; }
+	void reset_stats();
+
+private:
+	// Larger than the cost of a step, a cell queued at distance d waits in bucket d % BUCKETS
+	static const int BUCKETS = 16;
+
+	int anchor_row = -1;
+	int anchor_col = -1;
+	// The window clipped to the level, and the distances to the anchor in it, row by row
+	int window_row_min = 0, window_col_min = 0, window_row_max = -1, window_col_max = -1;
+	std::vector<uint16_t> anchor_distances;
+	std::vector<uint32_t> buckets[BUCKETS];
+	size_t touched = 0;
+	Stats update_stats;
+
+	// Puts a goal cell at distance 0 and queues it
+	void seed(int row, int col);
+	// Dijkstra from the queued cells over rows [row_min, row_max] and columns [col_min, col_max], distances only drop
+	void relax(int row_min, int col_min, int row_max, int col_max);
+	uint16_t anchor_distance(int row, int col) const;
+	// Whether a cell is a goal, unreached, or has a neighbour closer to the goal
+	bool descends(int row, int col) const;
+};
@@ -2,45 +2,243 @@
 #include "grid.hpp"
 #include "tiny_ecs_registry.hpp"
 #include <iostream>
-// Define the grid
-int grid[GRID_HEIGHT][GRID_WIDTH] = {{0}}; // Initialize all cells to 0 (unoccupied)
-int flowField[GRID_HEIGHT][GRID_WIDTH] = {{0}}; // Initialize all cells to 0 (unoccupied)
+#include <algorithm>
+// Define the level and its views
+Level level;
+CellGrid grid(level);
+DistanceField flowField(level);
 std::vector<sEdge> edges = {}; 
-sCell* cells = new sCell[GRID_HEIGHT * GRID_WIDTH];
 std::vector<std::tuple<float,float,float>> triangleCorners = {};
-void resetCorners(){
-    edges = {};
-    for (int i = 0;i<GRID_HEIGHT;i++){
-        for (int j = 0;j<GRID_WIDTH;j++){
-            for (int k = 0;k<4;k++){
-                cells[i*GRID_WIDTH + j].edge_exist[k] = false;
-                cells[i*GRID_WIDTH + j].edgeID[k] = 0;
-            }
+const uint64_t EVEN_BITS = 0x5555555555555555ull;
+// A word of CELL_WALL cells
+const uint64_t ALL_WALLS = EVEN_BITS * CELL_WALL;
+// The visibility cell of the cells without a chunk
+static const sCell EMPTY_CELL = {};
+
+static int lowest_bit(uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while ((bits >> bit & 1) == 0)
+        bit++;
+    return bit;
+#endif
+}
+
+void Level::resize(int width, int height)
+{
+    cols = std::max(width, 0);
+    rows = std::max(height, 0);
+    stride = chunks_x();
+    chunks.clear();
+    chunks.resize((size_t)chunks_x() * chunks_y());
+}
+
+size_t Level::allocated_chunks() const
+{
+    size_t count = 0;
+    for (const auto& chunk : chunks)
+        count += chunk != nullptr;
+    return count;
+}
+
+Level::Chunk& Level::touch(int row, int col)
+{
+    std::unique_ptr<Chunk>& chunk = chunks[slot(row, col)];
+    if (!chunk)
+    {
+        chunk.reset(new Chunk());
+        std::fill(std::begin(chunk->classes), std::end(chunk->classes), ALL_WALLS);
+        std::fill(std::begin(chunk->distances), std::end(chunk->distances), FLOW_UNREACHED);
+    }
+    return *chunk;
+}
+
+void Level::carve(int row_min, int col_min, int row_max, int col_max)
+{
+    row_min = std::max(row_min, 0);
+    row_max = std::min(row_max, rows - 1);
+    col_min = std::max(col_min, 0);
+    col_max = std::min(col_max, cols - 1);
+    for (int row = row_min; row <= row_max; row++)
+        for (int col = col_min; col <= col_max; col++)
+        {
+            // Floor is 00, clearing both bits of the cell
+            uint64_t& word = touch(row, col).classes[row % CHUNK_SIZE];
+            word &= ~(3ull << (col % CHUNK_SIZE * 2));
         }
+}
+
+void Level::release_solid_chunks()
+{
+    for (auto& chunk : chunks)
+    {
+        if (!chunk)
+            continue;
+        bool solid = std::all_of(std::begin(chunk->classes), std::end(chunk->classes), [](uint64_t word) { return word == ALL_WALLS; });
+        solid = solid && std::none_of(std::begin(chunk->cells), std::end(chunk->cells), [](const sCell& cell) { return cell.exist; });
+        if (solid)
+            chunk.reset();
+    }
+}
+
+const sCell& Level::cell(int row, int col) const
+{
+    const Chunk* found = chunk(row, col);
+    return found ? found->cells[(row % CHUNK_SIZE) * CHUNK_SIZE + col % CHUNK_SIZE] : EMPTY_CELL;
+}
+
+sCell* Level::find_cell(int row, int col)
+{
+    Chunk* found = chunk(row, col);
+    return found ? &found->cells[(row % CHUNK_SIZE) * CHUNK_SIZE + col % CHUNK_SIZE] : nullptr;
+}
+
+void Level::mark_wall_cell(int row, int col)
+{
+    if (inside(row, col))
+        touch(row, col).cells[(row % CHUNK_SIZE) * CHUNK_SIZE + col % CHUNK_SIZE].exist = true;
+}
+
+void Level::clear_wall_cells()
+{
+    for (auto& chunk : chunks)
+        if (chunk)
+            for (sCell& cell : chunk->cells)
+                cell.exist = false;
+}
+
+void CellGrid::set(int row, int col, int value)
+{
+    if (!level.inside(row, col))
+        return;
+    Level::Chunk* chunk = level.chunk(row, col);
+    if (!chunk)
+    {
+        if ((value & 3) == CELL_WALL)
+            return;
+        chunk = &level.touch(row, col);
+    }
+    uint64_t& word = chunk->classes[row % CHUNK_SIZE];
+    int shift = col % CELLS_PER_WORD * 2;
+    word = (word & ~(3ull << shift)) | (uint64_t)(value & 3) << shift;
+}
+
+uint64_t CellGrid::word(int row, int w) const
+{
+    const Level::Chunk* chunk = level.chunk(row, w * CELLS_PER_WORD);
+    return chunk ? chunk->classes[row % CHUNK_SIZE] : ALL_WALLS;
+}
+
+uint64_t CellGrid::match(uint64_t word, unsigned int classes)
+{
+    if (classes == CELLS_BLOCKED)
+        return (word | word >> 1) & EVEN_BITS;
+    uint64_t result = 0;
+    for (unsigned int c = 0; c < 4; c++)
+    {
+        if ((classes & 1u << c) == 0)
+            continue;
+        // The cells of class c become 00 and nothing else does
+        uint64_t diff = word ^ (EVEN_BITS * c);
+        result |= ~(diff | diff >> 1) & EVEN_BITS;
+    }
+    return result;
+}
+
+uint64_t CellGrid::span_mask(int w, int col_min, int col_max)
+{
+    int first = std::max(col_min - w * CELLS_PER_WORD, 0);
+    int last = std::min(col_max - w * CELLS_PER_WORD, CELLS_PER_WORD - 1);
+    if (first > last)
+        return 0;
+    uint64_t upto_last = last == CELLS_PER_WORD - 1 ? ~0ull : (1ull << (2 * last + 2)) - 1;
+    return upto_last & ~((1ull << 2 * first) - 1) & EVEN_BITS;
+}
+
+bool CellGrid::any_in_rect(int row_min, int col_min, int row_max, int col_max, unsigned int classes) const
+{
+    row_min = std::max(row_min, 0);
+    row_max = std::min(row_max, level.height() - 1);
+    col_min = std::max(col_min, 0);
+    col_max = std::min(col_max, level.width() - 1);
+    if (row_min > row_max || col_min > col_max)
+        return false;
+    for (int w = col_min / CELLS_PER_WORD; w <= col_max / CELLS_PER_WORD; w++)
+    {
+        uint64_t mask = span_mask(w, col_min, col_max);
+        for (int row = row_min; row <= row_max; row++)
+            if (match(word(row, w), classes) & mask)
+                return true;
     }
-    for (int x = 0; x < GRID_WIDTH ; x++)
-        for (int y = 0; y < GRID_HEIGHT ; y++){
-            // Create some convenient indices
-            int i = (y ) * GRID_WIDTH + (x );			// This
-            int n = (y  - 1) * GRID_WIDTH + (x );		// Northern Neighbour
-            int s = (y  + 1) * GRID_WIDTH + (x );		// Southern Neighbour
-            int w = (y ) * GRID_WIDTH + (x  - 1);	// Western Neighbour
-            int e = (y ) * GRID_WIDTH + (x  + 1);	// Eastern Neighbour
+    return false;
+}
+
+int CellGrid::first_in_row(int row, int col_min, int col_max, unsigned int classes) const
+{
+    if (row < 0 || row >= level.height())
+        return -1;
+    col_min = std::max(col_min, 0);
+    col_max = std::min(col_max, level.width() - 1);
+    for (int w = col_min / CELLS_PER_WORD; col_min <= col_max && w <= col_max / CELLS_PER_WORD; w++)
+    {
+        uint64_t bits = match(word(row, w), classes) & span_mask(w, col_min, col_max);
+        if (bits != 0)
+            return w * CELLS_PER_WORD + lowest_bit(bits) / 2;
+    }
+    return -1;
+}
+
+void DistanceField::fill(uint16_t value)
+{
+    for (int chunk_row = 0; chunk_row < level.chunks_y(); chunk_row++)
+        for (int chunk_col = 0; chunk_col < level.chunks_x(); chunk_col++)
+            if (Level::Chunk* chunk = level.chunk_at(chunk_row, chunk_col))
+                std::fill(std::begin(chunk->distances), std::end(chunk->distances), value);
+}
+
+void resetCorners(){
+    edges = {};
+    for (int cy = 0; cy < level.chunks_y(); cy++)
+        for (int cx = 0; cx < level.chunks_x(); cx++)
+            if (Level::Chunk* chunk = level.chunk_at(cy, cx))
+                for (sCell& cell : chunk->cells)
+                    for (int k = 0;k<4;k++){
+                        cell.edge_exist[k] = false;
+                        cell.edgeID[k] = 0;
+                    }
+    // Chunk by chunk, the northern and western neighbours of a cell are visited before it
+    for (int cy = 0; cy < level.chunks_y(); cy++)
+    for (int cx = 0; cx < level.chunks_x(); cx++){
+        if (!level.chunk_at(cy, cx))
+            continue;
+        int y_end = std::min((cy + 1) * CHUNK_SIZE, level.height());
+        int x_end = std::min((cx + 1) * CHUNK_SIZE, level.width());
+        for (int y = cy * CHUNK_SIZE; y < y_end; y++)
+        for (int x = cx * CHUNK_SIZE; x < x_end; x++){
+            // Create some convenient references
+            sCell& i = *level.find_cell(y, x);     // This
+            const sCell& n = level.cell(y - 1, x); // Northern Neighbour
+            const sCell& s = level.cell(y + 1, x); // Southern Neighbour
+            const sCell& w = level.cell(y, x - 1); // Western Neighbour
+            const sCell& e = level.cell(y, x + 1); // Eastern Neighbour
 
             // If this cell exists, check if it needs edges
-            if (cells[i].exist)
+            if (i.exist)
             {
                 // If this cell has no western neighbour, it needs a western edge
-                if (!cells[w].exist)
+                if (!w.exist)
                 {
                     // It can either extend it from its northern neighbour if they have
                     // one, or It can start a new one.
-                    if (cells[n].edge_exist[WEST])
+                    if (n.edge_exist[WEST])
                     {
                         // Northern neighbour has a western edge, so grow it downwards
-                        edges[cells[n].edgeID[WEST]].ey += 12;
-                        cells[i].edgeID[WEST] = cells[n].edgeID[WEST];
-                        cells[i].edge_exist[WEST] = true;
+                        edges[n.edgeID[WEST]].ey += 12;
+                        i.edgeID[WEST] = n.edgeID[WEST];
+                        i.edge_exist[WEST] = true;
                     }
                     else
                     {
@@ -54,22 +252,22 @@ void resetCorners(){
                         edges.push_back(edge);
 
                         // Update tile information with edge information
-                        cells[i].edgeID[WEST] = edgeID;
-                        cells[i].edge_exist[WEST] = true;
+                        i.edgeID[WEST] = edgeID;
+                        i.edge_exist[WEST] = true;
                     }
                 }
 
                 // If this cell dont have an eastern neignbour, It needs a eastern edge
-                if (!cells[e].exist)
+                if (!e.exist)
                 {
                     // It can either extend it from its northern neighbour if they have
                     // one, or It can start a new one.
-                    if (cells[n].edge_exist[EAST])
+                    if (n.edge_exist[EAST])
                     {
                         // Northern neighbour has one, so grow it downwards
-                        edges[cells[n].edgeID[EAST]].ey += 12.0f;
-                        cells[i].edgeID[EAST] = cells[n].edgeID[EAST];
-                        cells[i].edge_exist[EAST] = true;
+                        edges[n.edgeID[EAST]].ey += 12.0f;
+                        i.edgeID[EAST] = n.edgeID[EAST];
+                        i.edge_exist[EAST] = true;
                     }
                     else
                     {
@@ -83,22 +281,22 @@ void resetCorners(){
                         edges.push_back(edge);
 
                         // Update tile information with edge information
-                        cells[i].edgeID[EAST] = edgeID;
-                        cells[i].edge_exist[EAST] = true;
+                        i.edgeID[EAST] = edgeID;
+                        i.edge_exist[EAST] = true;
                     }
                 }
 
                 // If this cell doesnt have a northern neignbour, It needs a northern edge
-                if (!cells[n].exist)
+                if (!n.exist)
                 {
                     // It can either extend it from its western neighbour if they have
                     // one, or It can start a new one.
-                    if (cells[w].edge_exist[NORTH])
+                    if (w.edge_exist[NORTH])
                     {
                         // Western neighbour has one, so grow it eastwards
-                        edges[cells[w].edgeID[NORTH]].ex += 12.0f;
-                        cells[i].edgeID[NORTH] = cells[w].edgeID[NORTH];
-                        cells[i].edge_exist[NORTH] = true;
+                        edges[w.edgeID[NORTH]].ex += 12.0f;
+                        i.edgeID[NORTH] = w.edgeID[NORTH];
+                        i.edge_exist[NORTH] = true;
                     }
                     else
                     {
@@ -112,22 +310,22 @@ void resetCorners(){
                         edges.push_back(edge);
 
                         // Update tile information with edge information
-                        cells[i].edgeID[NORTH] = edgeID;
-                        cells[i].edge_exist[NORTH] = true;
+                        i.edgeID[NORTH] = edgeID;
+                        i.edge_exist[NORTH] = true;
                     }
                 }
 
                 // If this cell doesnt have a southern neignbour, It needs a southern edge
-                if (!cells[s].exist)
+                if (!s.exist)
                 {
                     // It can either extend it from its western neighbour if they have
                     // one, or It can start a new one.
-                    if (cells[w].edge_exist[SOUTH])
+                    if (w.edge_exist[SOUTH])
                     {
                         // Western neighbour has one, so grow it eastwards
-                        edges[cells[w].edgeID[SOUTH]].ex += 12.0f;
-                        cells[i].edgeID[SOUTH] = cells[w].edgeID[SOUTH];
-                        cells[i].edge_exist[SOUTH] = true;
+                        edges[w.edgeID[SOUTH]].ex += 12.0f;
+                        i.edgeID[SOUTH] = w.edgeID[SOUTH];
+                        i.edge_exist[SOUTH] = true;
                     }
                     else
                     {
@@ -141,14 +339,15 @@ void resetCorners(){
                         edges.push_back(edge);
 
                         // Update tile information with edge information
-                        cells[i].edgeID[SOUTH] = edgeID;
-                        cells[i].edge_exist[SOUTH] = true;
+                        i.edgeID[SOUTH] = edgeID;
+                        i.edge_exist[SOUTH] = true;
                     }
                 }
 
             }
 
         }
+    }
 
 }
 void CalculateVisibleTriangles(float radius)
@@ -156,10 +355,7 @@ void CalculateVisibleTriangles(float radius)
 		// Get rid of existing polygon
 
 		triangleCorners = {};
-        Entity player;
-        for (Entity entity : registry.players.entities) {
-            player = entity;
-        }
+        Entity player = registry.single_entity<Player>();
 		// For each edge in PolyMap
 		for (auto &e1 : edges)
 		{
@@ -13,8 +13,31 @@
 #define SOUTH 1
 #define WEST 3
 #endif // HASH_SPECIALIZATIONS_HPP
-const int GRID_WIDTH = 160;
-const int GRID_HEIGHT = 80;
+#include <stdint.h>
+#include <memory>
+#include <algorithm>
+
+// Size of the level when a room does not ask for more, in cells
+const int DEFAULT_LEVEL_WIDTH = 160;
+const int DEFAULT_LEVEL_HEIGHT = 80;
+// Side of a grid cell in pixels
+const float TILE_SIZE = 12.f;
+// Side of a level chunk in cells
+const int CHUNK_SIZE = 32;
+
+// What a grid cell holds, 2 bits each
+enum CELL_CLASS : unsigned int {
+    CELL_FLOOR = 0,
+    CELL_WALL = 1,
+    CELL_PADDING = 2, // floor next to a wall, enemies do not path through it
+    CELL_GOAL = 3
+};
+// Sets of cell classes for the queries of CellGrid
+const unsigned int CELLS_WALL = 1u << CELL_WALL;
+const unsigned int CELLS_BLOCKED = 1u << CELL_WALL | 1u << CELL_PADDING | 1u << CELL_GOAL;
+// Distance of the cells the flow field does not reach
+const uint16_t FLOW_UNREACHED = 0xffff;
+
 struct sEdge{
     float sx, sy, ex, ey;
 };
@@ -22,13 +45,194 @@ struct sCell{
     int edgeID[4];
     bool edge_exist[4];
     bool exist = false;
-};  
+};
+
+// The level: its size in cells and, for every cell, its class, its distance to the goal and its visibility edges.
+// The cells are stored in CHUNK_SIZE x CHUNK_SIZE chunks that only exist where a room was carved. A missing chunk
+// reads as walls the flow field never reaches, so the space around and inside a room costs no memory and no BFS time.
+class Level
+{
+public:
+    struct Chunk
+    {
+        uint64_t classes[CHUNK_SIZE]; // one chunk row per word, 2 bits per cell
+        uint16_t distances[CHUNK_SIZE * CHUNK_SIZE]; // in Z-order, see DistanceField
+        sCell cells[CHUNK_SIZE * CHUNK_SIZE]; // row by row
+    };
+
+    // Drops every chunk, all cells are walls until carved
+    void resize(int width, int height);
+    // Makes the cells of rows [row_min, row_max] and columns [col_min, col_max] floor
+    void carve(int row_min, int col_min, int row_max, int col_max);
+    // Drops the chunks holding nothing but walls without visibility cells, e.g. the inside of a donut room
+    void release_solid_chunks();
+
+    int width() const { return cols; }
+    int height() const { return rows; }
+    float width_px() const { return cols * TILE_SIZE; }
+    float height_px() const { return rows * TILE_SIZE; }
+    bool inside(int row, int col) const { return (unsigned)row < (unsigned)rows && (unsigned)col < (unsigned)cols; }
+    int chunks_x() const { return (cols + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+    int chunks_y() const { return (rows + CHUNK_SIZE - 1) / CHUNK_SIZE; }
+    size_t allocated_chunks() const;
+
+    // The chunk holding a cell, nullptr outside the level or where nothing was carved
+    const Chunk* chunk(int row, int col) const { return inside(row, col) ? chunks[slot(row, col)].get() : nullptr; }
+    Chunk* chunk(int row, int col) { return inside(row, col) ? chunks[slot(row, col)].get() : nullptr; }
+    // The chunk holding a cell inside the level, allocated as walls if it is missing
+    Chunk& touch(int row, int col);
+    // The chunk at chunk coordinates, or nullptr
+    Chunk* chunk_at(int chunk_row, int chunk_col) { return chunks[(size_t)chunk_row * stride + chunk_col].get(); }
+
+    // The visibility cell, an empty one where there is no chunk
+    const sCell& cell(int row, int col) const;
+    sCell* find_cell(int row, int col);
+    // Marks a cell as covered by a wall block for the visibility edges
+    void mark_wall_cell(int row, int col);
+    void clear_wall_cells();
+
+private:
+    int cols = 0, rows = 0;
+    int stride = 0; // chunks per row
+    std::vector<std::unique_ptr<Chunk>> chunks;
+
+    // Index of the chunk holding a cell inside the level
+    size_t slot(int row, int col) const { return (size_t)(row / CHUNK_SIZE) * stride + col / CHUNK_SIZE; }
+};
+
+// The class of every cell, 32 cells packed into each 64-bit word, one word per chunk row. A query over a row segment
+// compares 32 cells with a few mask operations, e.g. "any wall in this rectangle" reads one or two words per row.
+// grid[row][col] reads and writes a cell like the int array it replaces.
+class CellGrid
+{
+public:
+    static const int CELLS_PER_WORD = CHUNK_SIZE;
+
+    // One cell of a row, converts to and assigns from its class
+    class Cell
+    {
+        CellGrid& grid;
+        int row, col;
+    public:
+        Cell(CellGrid& grid, int row, int col) : grid(grid), row(row), col(col) {}
+        operator int() const { return grid.get(row, col); }
+        Cell& operator=(int value)
+        {
+            grid.set(row, col, value);
+            return *this;
+        }
+        Cell& operator=(const Cell& other) { return *this = (int)other; }
+    };
+    class Row
+    {
+        CellGrid& grid;
+        int row;
+    public:
+        Row(CellGrid& grid, int row) : grid(grid), row(row) {}
+        Cell operator[](int col) { return Cell(grid, row, col); }
+    };
+
+    explicit CellGrid(Level& level) : level(level) {}
+
+    Row operator[](int row) { return Row(*this, row); }
+    // Cells outside the level or its chunks are walls
+    int get(int row, int col) const
+    {
+        if (!level.inside(row, col))
+            return CELL_WALL;
+        return (int)(word(row, col / CELLS_PER_WORD) >> (col % CELLS_PER_WORD * 2) & 3);
+    }
+    // Writes outside the level are dropped, writing anything but a wall where there is no chunk allocates it
+    void set(int row, int col, int value);
+    bool inside(int row, int col) const { return level.inside(row, col); }
+    // Whether a cell is a wall, padding or goal
+    bool blocked(int row, int col) const { return get(row, col) != CELL_FLOOR; }
+
+    // Whether a cell of one of the 'classes' lies in rows [row_min, row_max] and columns [col_min, col_max],
+    // the part of the rectangle outside the level is ignored
+    bool any_in_rect(int row_min, int col_min, int row_max, int col_max, unsigned int classes) const;
+    // The first column in [col_min, col_max] of a row holding a cell of one of the 'classes', or -1
+    int first_in_row(int row, int col_min, int col_max, unsigned int classes) const;
+
+private:
+    Level& level;
+
+    // Word 'w' of a row, all walls where there is no chunk
+    uint64_t word(int row, int w) const;
+    // Bit 2k of the result is set when cell k of the word has one of the classes
+    static uint64_t match(uint64_t word, unsigned int classes);
+    // The bits of the cells [col_min, col_max] that fall into word 'w'
+    static uint64_t span_mask(int w, int col_min, int col_max);
+};
+
+// A 16-bit distance for every cell. Each chunk stores its cells in Z-order (Morton order), so the 8 neighbours of a
+// cell are usually in the same cache line or the next one.
+class DistanceField
+{
+public:
+    explicit DistanceField(Level& level) : level(level) {}
+
+    // FLOW_UNREACHED outside the level or its chunks
+    uint16_t get(int row, int col) const
+    {
+        const Level::Chunk* chunk = level.chunk(row, col);
+        if (!chunk)
+            return FLOW_UNREACHED;
+        uint16_t value = chunk->distances[index(row, col)];
+        if (outer_offset == 0 || value == FLOW_UNREACHED || in_window(row, col))
+            return value;
+        return (uint16_t)std::min<uint32_t>(value + outer_offset, FLOW_UNREACHED - 1);
+    }
+    // Stores the distance as it is, also outside the window. Cells without a chunk are walls and keep no distance.
+    void set(int row, int col, uint16_t value)
+    {
+        if (Level::Chunk* chunk = level.chunk(row, col))
+            chunk->distances[index(row, col)] = value;
+    }
+    // Sets the distance of every cell of the allocated chunks
+    void fill(uint16_t value);
+    // Outside rows [row_min, row_max] and columns [col_min, col_max] every reached cell reads 'offset' further,
+    // see FlowFieldUpdater
+    void set_outer_offset(int row_min, int col_min, int row_max, int col_max, uint16_t offset)
+    {
+        window_row_min = row_min;
+        window_col_min = col_min;
+        window_row_max = row_max;
+        window_col_max = col_max;
+        outer_offset = offset;
+    }
+
+    // Position of a cell in the distances of its chunk
+    static size_t index(int row, int col)
+    {
+        return morton_bits(col % CHUNK_SIZE) | morton_bits(row % CHUNK_SIZE) << 1;
+    }
+
+private:
+    Level& level;
+    int window_row_min = 0, window_col_min = 0, window_row_max = -1, window_col_max = -1;
+    uint16_t outer_offset = 0;
+
+    bool in_window(int row, int col) const
+    {
+        return row >= window_row_min && row <= window_row_max && col >= window_col_min && col <= window_col_max;
+    }
+
+    // Spreads the bits of v to the even bits
+    static uint32_t morton_bits(uint32_t v)
+    {
+        v = (v | v << 8) & 0x00ff00ff;
+        v = (v | v << 4) & 0x0f0f0f0f;
+        v = (v | v << 2) & 0x33333333;
+        return (v | v << 1) & 0x55555555;
+    }
+};
 extern std::vector<sEdge> edges; 
-extern sCell* cells;
 
-// Declare the grid
-extern int grid[GRID_HEIGHT][GRID_WIDTH];
-extern int flowField[GRID_HEIGHT][GRID_WIDTH];
+// Declare the level and the views of its grid and flow field
+extern Level level;
+extern CellGrid grid;
+extern DistanceField flowField;
 extern std::vector<std::tuple<float,float,float>> triangleCorners;
 void resetCorners();
 void CalculateVisibleTriangles(float radius);
\ No newline at end of file
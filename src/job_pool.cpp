@@ -0,0 +1,208 @@
+// internal
+#include "job_pool.hpp"
+
+#include <chrono>
+#include <stdio.h>
+
+JobPool jobs;
+
+// The deque of the calling thread, workers set theirs when they start
+static thread_local unsigned int current_queue = 0;
+
+unsigned int JobPool::default_worker_count()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	return threads > 1 ? threads - 1 : 0;
+}
+
+JobPool::JobPool(unsigned int worker_count)
+{
+	for (unsigned int i = 0; i <= worker_count; i++)
+		queues.emplace_back(new Queue);
+	for (unsigned int i = 1; i <= worker_count; i++)
+		workers.emplace_back(&JobPool::work, this, i);
+}
+
+JobPool::~JobPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void JobPool::push(unsigned int index, Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->jobs.push_back(std::move(job));
+	}
+	queued++;
+	// Taking the sleep mutex orders this push before a worker that is about to sleep checks 'queued'
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	wake.notify_one();
+}
+
+void JobPool::run(Group& group, std::function<void()> job)
+{
+	group.pending++;
+	push(current_queue, { std::move(job), &group });
+}
+
+void JobPool::then(Group& group, std::function<void()> continuation)
+{
+	bool queue_now;
+	{
+		std::lock_guard<std::mutex> lock(group.mutex);
+		queue_now = ++group.pending == 1; // all jobs already finished
+		if (!queue_now)
+			group.continuation = std::move(continuation);
+	}
+	if (queue_now)
+		push(current_queue, { std::move(continuation), &group });
+}
+
+bool JobPool::find_job(unsigned int index, Job& job)
+{
+	{
+		Queue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queued--;
+			return true;
+		}
+	}
+	for (size_t offset = 1; offset < queues.size(); offset++)
+	{
+		Queue& victim = *queues[(index + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queued--;
+			queues[index]->stats.stolen++;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobPool::execute(unsigned int index, Job& job)
+{
+	job.run();
+	queues[index]->stats.executed++;
+
+	// Only the continuation's reserved count is left, its job takes that count over
+	std::function<void()> continuation;
+	{
+		std::lock_guard<std::mutex> lock(job.group->mutex);
+		if (--job.group->pending == 1 && job.group->continuation)
+		{
+			continuation = std::move(job.group->continuation);
+			job.group->continuation = nullptr;
+		}
+	}
+	if (continuation)
+		push(index, { std::move(continuation), job.group });
+}
+
+void JobPool::wait(Group& group)
+{
+	unsigned int index = current_queue;
+	auto idle_start = std::chrono::steady_clock::now();
+	bool idle = false;
+	while (!group.done())
+	{
+		Job job;
+		if (find_job(index, job))
+		{
+			if (idle)
+				queues[index]->stats.idle_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - idle_start).count();
+			idle = false;
+			execute(index, job);
+		}
+		else
+		{
+			// The remaining jobs are running on other threads
+			if (!idle)
+				idle_start = std::chrono::steady_clock::now();
+			idle = true;
+			std::this_thread::yield();
+		}
+	}
+	if (idle)
+		queues[index]->stats.idle_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - idle_start).count();
+	// The thread that finished the last job may still hold the group mutex, the group must outlive that
+	std::lock_guard<std::mutex> lock(group.mutex);
+}
+
+void JobPool::parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& fn)
+{
+	if (chunk_size == 0)
+		chunk_size = 1;
+	if (count <= chunk_size || workers.empty())
+	{
+		if (count > 0)
+			fn(0, count);
+		return;
+	}
+	Group group;
+	for (size_t begin = 0; begin < count; begin += chunk_size)
+	{
+		size_t end = begin + chunk_size < count ? begin + chunk_size : count;
+		run(group, [&fn, begin, end]() { fn(begin, end); });
+	}
+	wait(group);
+}
+
+void JobPool::work(unsigned int index)
+{
+	current_queue = index;
+	while (true)
+	{
+		Job job;
+		if (find_job(index, job))
+		{
+			execute(index, job);
+			continue;
+		}
+		auto idle_start = std::chrono::steady_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+			if (stopping)
+				return;
+		}
+		queues[index]->stats.idle_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - idle_start).count();
+	}
+}
+
+void JobPool::print_stats() const
+{
+	printf("Job pool with %u workers:\n", worker_count());
+	for (size_t i = 0; i < queues.size(); i++)
+	{
+		const Stats& s = queues[i]->stats;
+		printf("  %s %zu: %llu jobs, %llu stolen, %.2f ms idle\n", i == 0 ? "owner " : "worker", i,
+			(unsigned long long)s.executed.load(), (unsigned long long)s.stolen.load(), s.idle_us.load() / 1000.0);
+	}
+}
+
+void JobPool::reset_stats()
+{
+	for (auto& queue : queues)
+	{
+		queue->stats.executed = 0;
+		queue->stats.stolen = 0;
+		queue->stats.idle_us = 0;
+	}
+}
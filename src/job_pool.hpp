@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+#include "tiny_ecs.hpp"
+
+// A pool of worker threads for data-parallel loops inside a system.
+// Every worker owns a deque of jobs: it pops its newest job first and, when it runs dry, steals the oldest job
+// of another deque. Jobs pushed by the thread that owns the pool (the main thread) go to deque 0,
+// and that thread runs jobs too while it waits for them.
+// Jobs must not create or destroy entities or add and remove components, record those in a CommandBuffer.
+class JobPool
+{
+public:
+	// A set of jobs that can be waited for, and an optional continuation that is queued once all of them finished
+	class Group
+	{
+		friend class JobPool;
+		std::atomic<int> pending{ 0 }; // queued and running jobs, plus one for a continuation waiting to be queued
+		std::mutex mutex; // guards finishing jobs and the continuation
+		std::function<void()> continuation;
+	public:
+		bool done() const { return pending.load() == 0; }
+	};
+
+	struct Stats
+	{
+		std::atomic<uint64_t> executed{ 0 };
+		std::atomic<uint64_t> stolen{ 0 };
+		std::atomic<uint64_t> idle_us{ 0 };
+	};
+
+	// Workers in addition to the owning thread, by default one per remaining hardware thread
+	explicit JobPool(unsigned int workers = default_worker_count());
+	~JobPool();
+
+	void run(Group& group, std::function<void()> job);
+	// Queue fn once every job of group finished, call it after running the jobs, it counts as a job of the group itself
+	void then(Group& group, std::function<void()> continuation);
+	// Run jobs until group is done, call this from the owning thread or from inside a job
+	void wait(Group& group);
+
+	// Calls fn(begin, end) for consecutive ranges of [0, count) of at most chunk_size and waits for all of them.
+	// Runs inline when there is a single chunk or no workers.
+	void parallel_for(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)>& fn);
+
+	// Calls fn(entity, component&) for every component of a container, split into ranges of about chunk_size
+	// components that start on a cache line boundary of the component array
+	template <typename Component, typename Fn>
+	void parallel_for(ComponentContainer<Component>& container, size_t chunk_size, Fn fn)
+	{
+		const size_t CACHE_LINE = 64;
+		size_t line = std::is_empty<Component>::value ? 1 : CACHE_LINE / gcd(CACHE_LINE, sizeof(Component));
+		chunk_size = ((chunk_size + line - 1) / line) * line;
+		parallel_for(container.size(), chunk_size, [&container, &fn](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+			{
+				Entity e = container.entities[i];
+				if constexpr (std::is_empty<Component>::value)
+					fn(e, container.get(e));
+				else
+					fn(e, container.components[i]);
+			}
+		});
+	}
+
+	unsigned int worker_count() const { return (unsigned int)workers.size(); }
+	// Statistics by deque, index 0 is the owning thread
+	const Stats& stats(unsigned int index) const { return queues[index]->stats; }
+	void print_stats() const;
+	void reset_stats();
+
+private:
+	struct Job
+	{
+		std::function<void()> run;
+		Group* group;
+	};
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+		Stats stats;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues; // one per worker plus the owning thread
+	std::vector<std::thread> workers;
+	std::atomic<int> queued{ 0 };
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	bool stopping = false;
+
+	static unsigned int default_worker_count();
+	static size_t gcd(size_t a, size_t b) { return b == 0 ? a : gcd(b, a % b); }
+	void push(unsigned int index, Job job);
+	// Pop the newest job of the own deque, or steal the oldest of another one
+	bool find_job(unsigned int index, Job& job);
+	void execute(unsigned int index, Job& job);
+	void work(unsigned int index);
+};
+
+// The job pool of the game, owned by the main thread
+extern JobPool jobs;
@@ -4,12 +4,16 @@
 
 // stlib
 #include <chrono>
+#include <cstdlib>
 // internal
 #include "physics_system.hpp"
 #include "render_system.hpp"
 #include "world_system.hpp"
 #include "ai_system.hpp"
 #include "world_init.hpp"
+#include "scheduler.hpp"
+#include "job_pool.hpp"
+#include "aabb_batch.hpp"
 
 #include "iostream"
 static bool wasKeyHPressed = false;
@@ -18,6 +22,21 @@ static bool wasKeyKPressed = false;
 
 using Clock = std::chrono::high_resolution_clock;
 
+// The simulation runs in fixed ticks, TICK_RATE in the environment overrides the ticks per second
+const float DEFAULT_TICK_RATE = 120.f;
+// Ticks run at most this often per frame to catch up, the rest of the time is dropped
+const int MAX_CATCH_UP_TICKS = 8;
+
+float tick_rate() {
+	const char* value = getenv("TICK_RATE");
+	float rate = value ? (float)atof(value) : DEFAULT_TICK_RATE;
+	if (rate < 10.f || rate > 1000.f) {
+		printf("TICK_RATE must be between 10 and 1000, using %.0f\n", DEFAULT_TICK_RATE);
+		rate = DEFAULT_TICK_RATE;
+	}
+	return rate;
+}
+
 bool is_button_clicked(float xs, float xl, float ys, float yl, float mouse_x, float mouse_y) {
     return mouse_x >= xs && mouse_x <= xl && mouse_y >= ys && mouse_y <= yl;
 }
@@ -65,14 +84,42 @@ int main()
 	std::string game_state = "home";
 
 	// initialize the main systems
+	registry.track_changes<Motion, Solid>(); // lets physics skip the flow field and visibility updates while nothing moves
 	renderer.init(window);
 	world.init(&renderer, &game_state);
 	ai.init(&renderer);	
 
-	// variable timestep loop
+	// The systems of a simulation tick in their sequential order, with the components they read and write.
+	// Systems that spawn or destroy entities run alone, the visibility and flow field updates overlap.
+	const float tick_ms = 1000.f / tick_rate();
+	float step_ms = tick_ms;
+	Scheduler scheduler;
+	// Global state outside the registry: the wall edges the visibility cast reads, the visibility polygon
+	// (triangleCorners and the physics visibility epoch) and the level's distance field with the flow field state
+	const uint64_t wall_edges = scheduler.resource("wall edges");
+	const uint64_t visibility = scheduler.resource("visibility polygon");
+	const uint64_t distance_field = scheduler.resource("distance field");
+	scheduler.add_exclusive("world.step", [&]() { world.step(step_ms); });
+	scheduler.add("world.handle_movement", ECSRegistry::mask<Wave, DeathTimer>(), ECSRegistry::mask<Motion>(), [&]() { world.handle_movement(step_ms); });
+	scheduler.add_exclusive("ai.step", [&]() { ai.step(step_ms); });
+	scheduler.add_exclusive("physics.step", [&]() { physics.step(step_ms); });
+	scheduler.add("physics.update_visibility", ECSRegistry::mask<Player, Motion, Solid>(), 0, wall_edges, visibility, [&]() { physics.update_visibility(); });
+	scheduler.add("physics.update_flow_field", ECSRegistry::mask<Player, Motion, Solid>(), 0, 0, distance_field, [&]() { physics.update_flow_field(); });
+	scheduler.add("physics.lerp", 0, ECSRegistry::mask<Motion, KillsEnemyLerpyDerp>(), [&]() { physics.lerp(step_ms, 1000); });
+	scheduler.add_exclusive("world.handle_collisions", [&]() { world.handle_collisions(); });
+
+	// fixed timestep loop, frames are drawn between the last two ticks
 	auto t = Clock::now();
 	int frames = 0;
+	int ticks = 0;
 	float time = 0;
+	float accumulator_ms = 0;
+	size_t dropped_ticks = 0;
+	printf("Simulating %.0f ticks per second\n", 1000.f / tick_ms);
+	// AABB_KERNEL in the environment picks a narrower box overlap kernel, e.g. "sse2" or "scalar" to compare them
+	const char* kernel = getenv("AABB_KERNEL");
+	if (kernel && !select_overlap_kernel(kernel))
+		printf("AABB_KERNEL %s is not supported, using %s\n", kernel, overlap_kernel_name());
 
 	double mouse_x, mouse_y;
 	while (!world.is_over()) {
@@ -92,17 +139,34 @@ int main()
 		auto now = Clock::now();
 		float elapsed_ms =
 			(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
+		renderer.set_interpolation(1.f);
 		if (game_state == "playing" || game_state == "tutorial") {
 			// Calculating elapsed times in milliseconds from the previous iteration
 			// auto now = Clock::now();
 			
 			t = now;
-			world.step(elapsed_ms);
-			world.handle_movement();
-			ai.step(elapsed_ms);
-			physics.step(elapsed_ms);
-			physics.lerp(elapsed_ms, 1000);
-			world.handle_collisions();
+			accumulator_ms += elapsed_ms;
+			int frame_ticks = 0;
+			while (accumulator_ms >= tick_ms && frame_ticks < MAX_CATCH_UP_TICKS && (game_state == "playing" || game_state == "tutorial")) {
+				renderer.save_previous_motions();
+				scheduler.run();
+				// Changes made from here on belong to the next tick
+				registry.next_epoch();
+				accumulator_ms -= tick_ms;
+				frame_ticks++;
+			}
+			// A hitch longer than the catch-up ticks would leave the simulation further behind every frame,
+			// the ticks it could not run are dropped instead. Leaving the game, e.g. at the end of a wave,
+			// discards the time that is left.
+			if (!(game_state == "playing" || game_state == "tutorial")) {
+				accumulator_ms = 0;
+			} else if (accumulator_ms >= tick_ms) {
+				size_t dropped = (size_t)(accumulator_ms / tick_ms);
+				dropped_ticks += dropped;
+				accumulator_ms -= dropped * tick_ms;
+			}
+			ticks += frame_ticks;
+			renderer.set_interpolation(accumulator_ms / tick_ms);
 			renderer.draw("the game bruh");
 
 			time += elapsed_ms;
@@ -112,9 +176,20 @@ int main()
 				int fps = static_cast<int>(frames / time_in_seconds);
 
 				world.update_title(fps);
+				if (debugging.in_debug_mode) {
+					printf("%d ticks of %.2f ms, %zu dropped since the start\n", ticks, tick_ms, dropped_ticks);
+					scheduler.print_timings();
+					jobs.print_stats();
+					printf("Contacts last frame: %zu\n", contacts.last_frame_size());
+					physics.print_collision_stats();
+					physics.print_flow_field_stats();
+				}
+				jobs.reset_stats();
+				physics.reset_flow_field_stats();
 
 				time = 0;
 				frames = 0;
+				ticks = 0;
 			}
 		} else if (game_state == "home") {
 			while (registry.shopItems.entities.size() > 0)
@@ -159,10 +234,7 @@ int main()
             if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
 				if (doors_state == 0) {
 					if (is_button_clicked(120, 410, 600, 680, mouse_x, mouse_y)) {
-						for (Entity entity : registry.waves.entities) {
-							Wave& wave = registry.waves.get(entity);
-							wave.state = "applied buffs and nerfs1";
-						}
+						registry.single<Wave>().state = "applied buffs and nerfs1";
 						for (Entity entity : registry.buffNerfs.entities) {
 							BuffNerf& bn = registry.buffNerfs.get(entity);
 							if (bn.show_d1 == 1) {
@@ -175,10 +247,7 @@ int main()
 				}
 				if (doors_state <= 1) {
 					if (is_button_clicked(500, 780, 600, 680, mouse_x, mouse_y)) {
-						for (Entity entity : registry.waves.entities) {
-							Wave& wave = registry.waves.get(entity);
-							wave.state = "applied buffs and nerfs2";
-						}
+						registry.single<Wave>().state = "applied buffs and nerfs2";
 						for (Entity entity : registry.buffNerfs.entities) {
 							BuffNerf& bn = registry.buffNerfs.get(entity);
 							if (bn.show_d2 == 1) {
@@ -190,10 +259,7 @@ int main()
 					} 
 				}
 				if (is_button_clicked(860, 1130, 600, 680, mouse_x, mouse_y)) {
-					for (Entity entity : registry.waves.entities) {
-						Wave& wave = registry.waves.get(entity);
-						wave.state = "applied buffs and nerfs3";
-					}
+					registry.single<Wave>().state = "applied buffs and nerfs3";
 					for (Entity entity : registry.buffNerfs.entities) {
 						BuffNerf& bn = registry.buffNerfs.get(entity);
 						if (bn.show_d3 == 1) {
@@ -255,6 +321,9 @@ int main()
 			}
 			wasKeyKPressed = isKeyKPressed;
 		}
+
+		// Changes made from here on belong to the next frame
+		registry.next_epoch();
 	}
 
 	return EXIT_SUCCESS;
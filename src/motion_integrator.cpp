@@ -0,0 +1,88 @@
+// internal
+#include "motion_integrator.hpp"
+
+#include "cpu_features.hpp"
+
+// Advances n floats, a multiple of the kernel's width: out[i] = p[i] + v[i] * dt.
+// The x and y of a vec2 get the same treatment, so the columns are processed as flat float arrays.
+// The arrays start 32-byte aligned and ranges start at multiples of 8 floats, so the vector loads are aligned.
+using IntegrateKernel = void (*)(float* out, const float* p, const float* v, size_t n, float dt);
+
+static void integrate_scalar(float* out, const float* p, const float* v, size_t n, float dt)
+{
+	for (size_t i = 0; i < n; i++)
+		out[i] = p[i] + v[i] * dt;
+}
+
+#ifdef CPU_X86
+
+KERNEL_TARGET("sse2")
+static void integrate_sse2(float* out, const float* p, const float* v, size_t n, float dt)
+{
+	const __m128 step = _mm_set1_ps(dt);
+	for (size_t i = 0; i < n; i += 4)
+		_mm_store_ps(out + i, _mm_add_ps(_mm_load_ps(p + i), _mm_mul_ps(_mm_load_ps(v + i), step)));
+}
+
+KERNEL_TARGET("avx")
+static void integrate_avx(float* out, const float* p, const float* v, size_t n, float dt)
+{
+	const __m256 step = _mm256_set1_ps(dt);
+	for (size_t i = 0; i < n; i += 8)
+		_mm256_store_ps(out + i, _mm256_add_ps(_mm256_load_ps(p + i), _mm256_mul_ps(_mm256_load_ps(v + i), step)));
+}
+
+#endif
+
+struct IntegrateKernelChoice
+{
+	const char* name;
+	size_t width;
+	IntegrateKernel run;
+};
+
+// Widest first, the scalar kernel is last and always supported
+static const IntegrateKernelChoice INTEGRATE_KERNELS[] = {
+#ifdef CPU_X86
+	{ "avx", 8, integrate_avx },
+	{ "sse2", 4, integrate_sse2 },
+#endif
+	{ "scalar", 1, integrate_scalar },
+};
+const size_t INTEGRATE_KERNEL_COUNT = sizeof(INTEGRATE_KERNELS) / sizeof(INTEGRATE_KERNELS[0]);
+
+static size_t widest_integrate_kernel()
+{
+	for (size_t i = 0; i < INTEGRATE_KERNEL_COUNT; i++)
+		if (cpu_supports(INTEGRATE_KERNELS[i].name))
+			return i;
+	return INTEGRATE_KERNEL_COUNT - 1;
+}
+
+static const size_t integrate_kernel = widest_integrate_kernel();
+
+const char* integrate_kernel_name()
+{
+	return INTEGRATE_KERNELS[integrate_kernel].name;
+}
+
+void MotionIntegrator::integrate(const ComponentContainer<Motion>& motions, float dt)
+{
+	integrate(motions, dt, 0, size());
+}
+
+// The chosen kernel takes the whole vectors, the scalar loop the remainder
+void MotionIntegrator::integrate(const ComponentContainer<Motion>& motions, float dt, size_t begin, size_t end)
+{
+	assert(begin % 4 == 0 && end <= motions.position.size());
+	if (begin >= end)
+		return;
+	const IntegrateKernelChoice& kernel = INTEGRATE_KERNELS[integrate_kernel];
+	float* out = &predicted[begin].x;
+	const float* p = &motions.position[begin].x;
+	const float* v = &motions.velocity[begin].x;
+	size_t n = 2 * (end - begin);
+	size_t vectors = n / kernel.width * kernel.width;
+	kernel.run(out, p, v, vectors, dt);
+	integrate_scalar(out + vectors, p + vectors, v + vectors, n - vectors, dt);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include "common.hpp"
+#include "tiny_ecs.hpp"
+#include "components.hpp"
+
+// Predicted positions of every row of the Motion columns, position + velocity * dt, computed in one vectorized pass
+// over the contiguous position and velocity columns. Systems then decide per type from the prediction of a row
+// whether to commit it, e.g. after checking for walls. The prediction keeps its capacity between steps.
+class MotionIntegrator
+{
+public:
+	AlignedVector<vec2> predicted; // by row of the Motion container
+
+	// Rows per job when the prediction is split over threads, a multiple of the vector width
+	// so every range starts aligned, and 8 rows fill a cache line of each column
+	static const size_t CHUNK = 1024;
+
+	// Size the prediction for every row of motions, call before integrate()
+	void resize(const ComponentContainer<Motion>& motions) { predicted.resize(motions.position.size()); }
+	size_t size() const { return predicted.size(); }
+
+	// predicted = position + velocity * dt for every row, with the widest kernel the CPU supports
+	void integrate(const ComponentContainer<Motion>& motions, float dt);
+	// The same for rows [begin, end), begin must be a multiple of 4 to keep the vector loads aligned
+	void integrate(const ComponentContainer<Motion>& motions, float dt, size_t begin, size_t end);
+};
+
+// Name of the kernel integrate() runs: "avx", "sse2" or "scalar"
+const char* integrate_kernel_name();
@@ -2,126 +2,46 @@
 #include "physics_system.hpp"
 #include "world_init.hpp"
 #include "iostream"
-#include <queue>
 #include <utility>
+#include "job_pool.hpp"
+#include "tile_sweep.hpp"
+#include <chrono>
 using namespace std;
 // const float COLLECT_DIST = 100.0f;  
-const int dRow[] = {-1, -1, 0, 1, 1, 1, 0, -1}; // Up, Up-Right, Right, Down-Right, Down, Down-Left, Left, Up-Left
-const int dCol[] = {0, 1, 1, 1, 0, -1, -1, -1}; // Corresponding columns
+ContactBuffer contacts;
 
+// Coins per job of the coin magnet, below this many coins it runs on the calling thread
+const size_t COIN_CHUNK = 256;
+// Broadphase cells per narrowphase job
+const size_t NARROWPHASE_CELLS = 32;
+// The player slides along the walls with its sprite box (Motion::scale) shrunk by this margin on every side, so a box
+// flush against a wall doesn't catch on the next tile. The Collider is not used: it follows the animation frame, and a
+// box that grows between frames could start a move inside a wall.
+const float WALL_MARGIN = 1.f;
 
-bool isValid(int row, int col) {
-    // If cell lies out of bounds
-    if (row < 0 || col < 0 || row >= 80 || col >= 160)
-        return false;
 
-    // If cell is already visited or is a wall or goal
-    if (grid[row][col] == 1 || grid[row][col] == 2|| grid[row][col] == 3)
-        return false;
-
-    return true;
-}
-
-void generateFlowField(int row, int col) {
-    // Initialize flowField
-    for (int i = 0; i < 80; i++) {
-        for (int j = 0; j < 160; j++) {
-            if (flowField[i][j] < 5000) {
-                flowField[i][j] = 5000;
-            }
-        }
-    }
-    flowField[row][col] = 0;
-	flowField[row][col-1] = 0;
-    // Stores indices of the matrix cells
-    queue<pair<int, int>> q;
-    q.push({row, col});
-	q.push({row, col-1});
-
-    while (!q.empty()) {
-        pair<int, int> cell = q.front();
-        int y = cell.first;
-        int x = cell.second;
-        q.pop();
-
-        // Explore all 8 adjacent cells
-		for (int i = 0; i < 8; i++) {
-			int adjx = x + dCol[i];
-			int adjy = y + dRow[i];
-			
-			// Ensure adjx and adjy are within bounds before accessing arrays
-			if (isValid(adjy, adjx)) {
-				// Determine if the direction is diagonal
-				bool isDiagonal = (dRow[i] != 0) && (dCol[i] != 0);
-				float cost = isDiagonal ? 14: 10;
-				if (flowField[adjy][adjx]<5000){
-					if (flowField[adjy][adjx] > flowField[y][x] + cost) {
-						flowField[adjy][adjx] = flowField[y][x] + cost;
-					}
-				}else{
-					flowField[adjy][adjx] = flowField[y][x] + cost;
-					q.push({adjy, adjx});
-				}
-					
-			}
-		}
-    }
+// Index of a collision layer, COLLISION_LAYER_COUNT for colliders without a filter
+int layer_index(uint32_t layer)
+{
+	for (int i = 0; i < COLLISION_LAYER_COUNT; i++)
+		if (layer == 1u << i)
+			return i;
+	return COLLISION_LAYER_COUNT;
 }
 
+const char* LAYER_NAMES[COLLISION_LAYER_COUNT + 1] = { "player", "enemy", "player projectile", "enemy projectile", "pickup", "static", "ui", "unfiltered" };
 
 // Returns the local bounding coordinates scaled by the current size of the entity
-vec2 get_bounding_box(const Motion& motion)
+vec2 get_bounding_box(const MotionRef& motion)
 {
 	// abs is to avoid negative scale due to the facing direction.
 	return { abs(motion.scale.x), abs(motion.scale.y) };
 }
 
-// This is a SUPER APPROXIMATE check that puts a circle around the bounding boxes and sees
-// if the center point of either object is inside the other's bounding-box-circle. You can
-// surely implement a more accurate detection
-
-bool collides(const Motion& motion1, const Motion& motion2)
-{
-    vec2 pos1 = motion1.position;
-    vec2 pos2 = motion2.position;
-    vec2 halfSize1 = get_bounding_box(motion1) / 2.f;
-    vec2 halfSize2 = get_bounding_box(motion2) / 2.f;
-
-    bool overlapX = (pos1.x - halfSize1.x < pos2.x + halfSize2.x) && (pos1.x + halfSize1.x > pos2.x - halfSize2.x);
-
-    bool overlapY = (pos1.y - halfSize1.y < pos2.y + halfSize2.y) && (pos1.y + halfSize1.y > pos2.y - halfSize2.y);
-
-    return overlapX && overlapY;
-}
-
-bool vertexCollidesWithBoundingBox(Entity player_entity, Motion& other_motion) {
-    Mesh& mesh = *registry.meshPtrs.get(player_entity);
-    Motion& player_motion = registry.motions.get(player_entity);
-
-    Transform transform;
-    transform.translate(player_motion.position);
-    transform.rotate(player_motion.angle);
-    transform.scale(player_motion.scale);
-
-    vec2 other_half_size = get_bounding_box(other_motion) / 2.f;
-    vec2 other_min = other_motion.position - other_half_size;
-    vec2 other_max = other_motion.position + other_half_size;
-    for (ColoredVertex vertex : mesh.vertices) {
-        vec3 worldPosition = transform.mat * vec3(vertex.position.x, vertex.position.y, 1.0f);
-        vec2 worldPos2D = vec2(worldPosition.x, worldPosition.y);
-
-        if (worldPos2D.x >= other_min.x && worldPos2D.x <= other_max.x &&
-            worldPos2D.y >= other_min.y && worldPos2D.y <= other_max.y) {
-            return true;
-        }
-    }
-
-    return false;
-}
 void PhysicsSystem::lerp(float elapsed_ms,float total_ms) {
 	auto& motion_registry = registry.motions;
 	for (Entity entity : registry.killsEnemyLerpyDerps.entities) {
-		Motion& motion = motion_registry.get(entity);
+		MotionRef motion = motion_registry.get(entity);
 		KillsEnemyLerpyDerp& kills = registry.killsEnemyLerpyDerps.get(entity);
 		kills.total_time += elapsed_ms/2;
 		motion.position.x = (1 - kills.total_time/total_ms) * kills.start_pos.x + kills.total_time/total_ms * kills.end_pos.x;
@@ -130,92 +50,71 @@ void PhysicsSystem::lerp(float elapsed_ms,float total_ms) {
 	}
 }
 
+// The visibility polygon only depends on the player position and the walls
+void PhysicsSystem::update_visibility() {
+	if (registry.players.size() == 0)
+		return;
+	Entity player = registry.single_entity<Player>();
+	if (registry.solids.modified_since(visibility_epoch) || registry.motions.modified_since(player, visibility_epoch)) {
+		CalculateVisibleTriangles(2000.0f);
+		visibility_epoch = registry.epoch();
+	}
+}
+
+// The flow field leads to the player cell around the walls, it is rebuilt when the walls change and repaired when the
+// player enters another cell
+void PhysicsSystem::update_flow_field() {
+	if (registry.players.size() == 0)
+		return;
+	Entity player = registry.single_entity<Player>();
+	bool walls_changed = registry.solids.modified_since(flow_field_epoch);
+	if (walls_changed || registry.motions.modified_since(player, flow_field_epoch)) {
+		MotionRef player_motion = registry.motions.get(player);
+		int row = static_cast<int>(player_motion.position.y / 12);
+		int col = static_cast<int>(player_motion.position.x / 12);
+		if (walls_changed) {
+			flow_field.rebuild(row, col);
+			flow_field_row = row;
+			flow_field_col = col;
+		} else if (row != flow_field_row || col != flow_field_col) {
+			flow_field.move_goal(row, col);
+			flow_field_row = row;
+			flow_field_col = col;
+		}
+		flow_field_epoch = registry.epoch();
+	}
+}
+
 void PhysicsSystem::step(float elapsed_ms)
 {
 	// Move fish based on how much time has passed, this is to (partially) avoid
 	// having entities move at different speed based on the machine.
-	for (Entity entity : registry.waves.entities) {
-		Wave& wave = registry.waves.get(entity);
-		if (wave.state != "game on" && wave.state != "limbo") {
-			return;
-		} 
+	Wave& wave = registry.single<Wave>();
+	if (wave.state != "game on" && wave.state != "limbo") {
+		return;
 	}
 	auto& motion_registry = registry.motions;
 	float step_seconds = elapsed_ms / 1000.f;
 	for (Entity entity : registry.players.entities) {
 		// move this wall collision handling to world_system.handle collision once bounding box is fixed
-		Motion& player_motion = motion_registry.get(entity);
+		MotionRef player_motion = motion_registry.get(entity);
 		Player& your = registry.players.get(entity);
-        // Update x position
-	   // Calculate the new position
-	           // Calculate the range of grid cells the player previously occupied
-
-        int prevMinGridX = static_cast<int>(player_motion.previous_position.x - 23) / 12;
-        int prevMaxGridX = static_cast<int>(player_motion.previous_position.x + 23) / 12;
-        int prevMinGridY = static_cast<int>(player_motion.previous_position.y - 35) / 12;
-        int prevMaxGridY = static_cast<int>(player_motion.previous_position.y + 35) / 12;
-
-
-        vec2 new_position = player_motion.position + (player_motion.velocity + your.push) * step_seconds;
-        // Calculate the range of grid cells the player will occupy
-
-        int minGridX = static_cast<int>(new_position.x - 23) / 12;
-        int maxGridX = static_cast<int>(new_position.x + 23) / 12;
-        int minGridY = static_cast<int>(new_position.y - 35) / 12;
-        int maxGridY = static_cast<int>(new_position.y + 35) / 12;
-
-        // Clear the previous grid cells
-        // Calculate the range of grid cells the player will occupy
-        bool canMoveX = true;
-        for (int y = prevMinGridY; y <= prevMaxGridY; ++y) {
-            for (int x = minGridX; x <= maxGridX; ++x) {
-                if (grid[y][x] == 1) {
-                    canMoveX = false;
-                    break;
-                }
-            }
-            if (!canMoveX) break;
-        }
-		bool canMoveY = true;
-        for (int y = minGridY; y <= maxGridY; ++y) {
-            for (int x = prevMinGridX; x <= prevMaxGridX; ++x) {
-                if (grid[y][x] == 1) {
-                    canMoveY = false;
-                    break;
-                }
-            }
-            if (!canMoveY) break;
-        }
-
-        if (canMoveX) {
-            // Update the player's X position
-            player_motion.position.x = new_position.x;
-            // Update the new grid cells for X movement
-
-        } else {
-            // Handle collision by stopping the player's X movement
-            player_motion.velocity.x = 0;
-            your.push.x = 0;
-        }
-        // Check if the player can move to the new position
-
-        if (canMoveY) {
-            // Update the player's Y position
-            player_motion.position.y = new_position.y;
-            // Update the new grid cells for Y movement
-
-        } else {
-            // Handle collision by stopping the player's Y movement
-            player_motion.velocity.y = 0;
-            your.push.y = 0;
-        }
-		if (canMoveX || canMoveY) {
-			// Update the flow field
-			CalculateVisibleTriangles(2000.0f);
-			
-			generateFlowField(static_cast<int>(player_motion.position.y / 12), static_cast<int>(player_motion.position.x / 12));
-
+		// Slide along the walls, a blocked axis loses its velocity and push
+		const vec2 wall_half_size = get_bounding_box(player_motion) / 2.f - WALL_MARGIN;
+		TileMove move = slide_tiles(player_motion.position, wall_half_size, (player_motion.velocity + your.push) * step_seconds);
+		vec2 moved_to = move.position;
+		if (move.hit_x) {
+			player_motion.velocity.x = 0;
+			your.push.x = 0;
+		}
+		if (move.hit_y) {
+			player_motion.velocity.y = 0;
+			your.push.y = 0;
 		}
+		if (moved_to != player_motion.position) {
+			motion_registry.patch(entity, [&](MotionRef motion) { motion.position = moved_to; });
+		}
+		// The visibility polygon and the flow field follow in update_visibility() and update_flow_field()
 
         // Update the previous position
         player_motion.previous_position = player_motion.position;
@@ -229,251 +128,247 @@ void PhysicsSystem::step(float elapsed_ms)
         //         motion.velocity = {0, 0};
         //     }
         // }
-		your.push *= 0.5f;
+		your.push *= pow(0.5f, elapsed_ms / FRAME_MS);
 
 
-		for (Entity entity : registry.eatables.entities) {
-			Motion& motion = registry.motions.get(entity);
+		// Every coin only writes its own motion, so the coins are split over the job pool
+		jobs.parallel_for(registry.eatables, COIN_CHUNK, [&](Entity entity, Eatable&) {
+			MotionRef motion = registry.motions.get(entity);
 			float dist = length(player_motion.position - motion.position);
 			if (dist < your.collect_dist && dist > 0.f) {
 				motion.velocity = 300.f*(your.collect_dist / (dist + your.collect_dist)) * normalize(player_motion.position - motion.position);
 			} else {
 				motion.velocity = {0, 0};
 			}
-		}
+		});
 	}
 
-	for(Entity entity : registry.killsEnemys.entities){ {
-		Motion& motion = motion_registry.get(entity);
+	// Predict the next position of every Motion row in one vectorized pass over the position and velocity columns,
+	// the per-type passes below decide from the predicted positions what to commit
+	movers.resize(motion_registry);
+	jobs.parallel_for(movers.size(), MotionIntegrator::CHUNK, [&](size_t begin, size_t end) {
+		movers.integrate(motion_registry, step_seconds, begin, end);
+	});
+
+	for (Entity entity : registry.killsEnemys.entities) {
+		size_t row = motion_registry.row(entity);
+		MotionRef motion = motion_registry.at(row);
 		KillsEnemy& kills = registry.killsEnemys.get(entity);
-		if(motion.scale.x == DIAMOND_PROJECTILE_BB_HEIGHT && motion.scale.y == DIAMOND_PROJECTILE_BB_HEIGHT){
+		if(kills.type == PROJECTILE::DIAMOND_STAR_PROJECTILE){
 			motion.angle += 2.0f * step_seconds;
 		}
 		
-		vec2 new_position = motion.position + motion.velocity * step_seconds;
-
-		// Determine the half dimensions
-		float half_width = motion.velocity.x>0?abs(motion.scale.x):-abs(motion.scale.x);
-		float half_height = motion.velocity.y>0?abs(motion.scale.y):-abs(motion.scale.y);
-
-		// Calculate the grid indices
-
-		int grid_x = static_cast<int>((new_position.x + half_width) / 12);
-		int grid_y = static_cast<int>((new_position.y + half_height) / 12);
-
-		if (kills.type == PROJECTILE::ROULETTE_BALL) {
-			if (grid[grid_y][grid_x] == 1) {
-				if (kills.bounce_left <= 0) {
-					registry.remove_all_components_of(entity);
-				} else {
-					kills.bounce_left -= 1;
-
-					// Calculate the center of the collided block
-
-					float block_center_x = (grid_x * 12)+6 ;
-					float block_center_y = (grid_y * 12)+6 ;
-
-					// Calculate the difference vector between the ball and the block center
-					float diff_x = block_center_x - new_position.x;
-					float diff_y = block_center_y -new_position.y;
-					// Calculate the angle of collision
-					float angle = atan2(-diff_y, diff_x);
-					// Determine the side of collision based on the angle
-
-					// Determine the side of collision based on the angle
-					if (angle > M_PI / 4 && angle <= 3 * M_PI / 4) {
-						// Collision from the top
-						if (grid[grid_y+1][grid_x] == 1){
-							motion.velocity.x *= -1;
-						} else{
-							motion.velocity.y *= -1;
-						}	
-					} else if (angle > -3 * M_PI / 4 && angle <= -M_PI / 4) {
-						// Collision from the bottom
-						if (grid[grid_y-1][grid_x] == 1){
-							motion.velocity.x *= -1;
-						} else{
-							motion.velocity.y *= -1;
-						}	
-					} else if (angle > 3 * M_PI / 4 || angle <= -3 * M_PI / 4) {
-						// Collision from the right
-						if (grid[grid_y][grid_x+1] == 1){
-							motion.velocity.y *= -1;
-						} else{
-							motion.velocity.x *= -1;
-						}	
-						
-					} else {
-						// Collision from the left
-						if (grid[grid_y][grid_x-1] == 1){
-							motion.velocity.y *= -1;
-						} else{
-							motion.velocity.x *= -1;
-						}	
-					}
-
-
-
-				}
+		vec2 new_position = movers.predicted[row];
+
+		TileHit hit = sweep_tiles(motion.position, get_bounding_box(motion) / 2.f, new_position - motion.position);
+		if (!hit.hit) {
+			motion.position = new_position;
+		} else if (kills.type == PROJECTILE::ROULETTE_BALL && kills.bounce_left > 0) {
+			// Bounce off the side of the wall that was hit
+			kills.bounce_left -= 1;
+			motion.position = hit.position;
+			if (hit.normal.x != 0) {
+				motion.velocity.x *= -1;
 			} else {
-				// No collision; update the position normally
-				motion.position += motion.velocity * step_seconds;	
+				motion.velocity.y *= -1;
 			}
-		} else{
-
-				if (grid[static_cast<int>((motion.position.y+half_height/2)/12)][static_cast<int>((motion.position.x+half_width/2)/12)] == 1) {
-
-					registry.remove_all_components_of(entity);
-				} else{
-					motion.position += motion.velocity * step_seconds;
-				}
+		} else {
+			registry.commands.destroy(entity);
 		}
 	}
 	for (Entity entity : registry.killsEnemyLerpyDerps.entities) {
-		Motion& motion = motion_registry.get(entity);
-		motion.position += motion.velocity * step_seconds;
-	}
+		size_t row = motion_registry.row(entity);
+		motion_registry.position[row] = movers.predicted[row];
 	}
     for (Entity entity : registry.deadlys.entities) {
         if (!motion_registry.has(entity)) {
             continue;
         }
-
-
-        Motion& motion = motion_registry.get(entity);
+        size_t row = motion_registry.row(entity);
+        MotionRef motion = motion_registry.at(row);
 		Deadly& deadly = registry.deadlys.get(entity);
-        vec2 new_position = motion.position + motion.velocity * step_seconds;
-
-        float width = motion.velocity.x > 0 ? std::abs(motion.scale.x / 2) : -std::abs(motion.scale.x / 2);
-        float height = motion.velocity.y > 0 ? std::abs(motion.scale.y / 2) : -std::abs(motion.scale.y / 2);
-
-        int grid_x = static_cast<int>((new_position.x + width) / 12);
-        int grid_y = static_cast<int>((new_position.y + height) / 12);
+        vec2 new_position = movers.predicted[row];
 
-        // Validate grid indices
-        if (grid_y < 0 || grid_y >= 80 || grid_x < 0 || grid_x >= 160) {
-            registry.remove_all_components_of(entity);
+        // Enemies outside of the level are removed, the sweeps below treat the tiles around it as walls
+        int grid_x = static_cast<int>(std::floor(motion.position.x / TILE_SIZE));
+        int grid_y = static_cast<int>(std::floor(motion.position.y / TILE_SIZE));
+        if (!grid.inside(grid_y, grid_x)) {
+            registry.commands.destroy(entity);
             continue;
         }
 
-		Motion* player_motion;
-		for (Entity entity : registry.players.entities) {
-			player_motion = &registry.motions.get(entity);
-		}
-
-      if (grid[grid_y][grid_x] == 1) {
-        if (registry.boids.has(entity) || registry.otherDeadlys.has(entity)) {
-          if (grid[grid_y][(int)((motion.position.x + width) / 12)] == 1) {
-            motion.velocity.x = -motion.velocity.x;
-          }
-          if (grid[(int)((motion.position.y + height) / 12)][grid_x] == 1) {
-            motion.velocity.y = -motion.velocity.y;
-          }
-          motion.position += motion.velocity * step_seconds;
-		}
-		else if (deadly.enemy_type == ENEMIES::BOSS_GENIE) {
-			Genie& genie = registry.genies.get(entity);
-			motion.position = findGenieTeleportPosition(player_motion->position, motion.position);
-			genie.teleport_timer = 2000.f;
+		MotionRef player_motion = registry.motions.get(registry.single_entity<Player>());
 
-			genie_teleport = Mix_LoadWAV(audio_path("genie_teleport.wav").c_str());
-			Mix_PlayChannel(10, genie_teleport, 0);
+		vec2 half_size = get_bounding_box(motion) / 2.f;
+		if (registry.boids.has(entity) || registry.otherDeadlys.has(entity)) {
+			// Birds fly up to the wall and bounce off it
+			TileHit hit = sweep_tiles(motion.position, half_size, new_position - motion.position);
+			motion.position = hit.position;
+			if (hit.normal.x != 0) {
+				motion.velocity.x = -motion.velocity.x;
+			}
+			if (hit.normal.y != 0) {
+				motion.velocity.y = -motion.velocity.y;
+			}
+		} else if (deadly.enemy_type == ENEMIES::BOSS_GENIE) {
+			if (sweep_tiles(motion.position, half_size, new_position - motion.position).hit) {
+				Genie& genie = registry.genies.get(entity);
+				motion.position = findGenieTeleportPosition(player_motion.position, motion.position);
+				genie.teleport_timer = 2000.f;
+
+				genie_teleport = Mix_LoadWAV(audio_path("genie_teleport.wav").c_str());
+				Mix_PlayChannel(10, genie_teleport, 0);
+			} else {
+				motion.position = new_position;
+			}
+		} else {
+			// Walking enemies slide along the walls
+			motion.position = slide_tiles(motion.position, half_size, new_position - motion.position).position;
 		}
-      } else {
-        motion.position += motion.velocity * step_seconds;
-      }
     }
 
 
-	for (Entity entity : registry.otherDeadlys.entities) {
-		Motion& motion = motion_registry.get(entity);
-		Deadly& deadly = registry.deadlys.get(entity);
+	// Boss birds are deadly and other deadly, they get a second step here
+	registry.view<OtherDeadly, Deadly, Motion>().each([&](Entity, OtherDeadly&, Deadly& deadly, MotionRef motion) {
 		if (deadly.enemy_type == ENEMIES::BOSS_BIRD_CLUBS) {
-			motion.position += motion.velocity * step_seconds;
+			TileHit hit = sweep_tiles(motion.position, get_bounding_box(motion) / 2.f, motion.velocity * step_seconds);
+			motion.position = hit.position;
+			if (hit.normal.x != 0) {
+				motion.velocity.x = -motion.velocity.x;
+			}
+			if (hit.normal.y != 0) {
+				motion.velocity.y = -motion.velocity.y;
+			}
 		}
-	}
+	});
 
 	for (Entity entity : registry.eatables.entities) {
-		Motion& motion = motion_registry.get(entity);
-		motion.position += motion.velocity * step_seconds;
+		size_t row = motion_registry.row(entity);
+		motion_registry.position[row] = movers.predicted[row];
 	}
 
 	for (Entity entity : registry.healsEnemies.entities) {
-		Motion& motion = motion_registry.get(entity);
-		float new_position_x = motion.position.x + (motion.velocity.x) * step_seconds;
-		float new_position_y = motion.position.y + (motion.velocity.y) * step_seconds;
-		bool can_move_x = grid[(int)motion.position.y / 12][(int)new_position_x / 12] != 1;
-    	bool can_move_y = grid[(int)new_position_y / 12][(int)motion.position.x / 12] != 1;
-
-    	if (can_move_x && !can_move_y) {
-        	motion.position.x = new_position_x;
-        	motion.velocity.y = 0;
-   		} else if (!can_move_x && can_move_y) {
-        	motion.position.y = new_position_y;
-        	motion.velocity.x = 0;
-    	} else if (can_move_x && can_move_y) {
-        	motion.position.x = new_position_x;
-       		motion.position.y = new_position_y;
-    	} else {
-        	motion.velocity.x = 0;
-        	motion.velocity.y = 0;
-    	}
+		size_t row = motion_registry.row(entity);
+		MotionRef motion = motion_registry.at(row);
+		// Hearts slide along the walls and lose the velocity into them
+		TileMove move = slide_tiles(motion.position, get_bounding_box(motion) / 2.f, movers.predicted[row] - motion.position);
+		motion.position = move.position;
+		if (move.hit_x) {
+			motion.velocity.x = 0;
+		}
+		if (move.hit_y) {
+			motion.velocity.y = 0;
+		}
 	}
 	if (debugging.in_debug_mode){
 		for (Entity entity : registry.motions.entities) {
 			if (registry.motions.has(entity)) {
 
-				if (registry.hud.has(entity)) {
+				if (registry.has<HUD>(entity)) {
 					continue;
 				}
 
-				Motion &motion = registry.motions.get(entity);
-				if (registry.players.has(entity)||!registry.collisions.has(entity)||registry.eatables.has(entity)||registry.deadlys.has(entity)) {
-					float min_x = motion.position.x - motion.scale.x / 2;
-					float max_x = motion.position.x + motion.scale.x / 2;
-					float min_y = motion.position.y - motion.scale.y / 2;
-					float max_y = motion.position.y + motion.scale.y / 2;
-					createLine({(min_x+max_x)/2, min_y}, {max_x - min_x, 2}); 
-					createLine({(min_x+max_x)/2, max_y}, {max_x - min_x, 2}); 
-					createLine({min_x, (min_y+max_y)/2}, {2, max_y - min_y}); 
-					createLine({max_x, (min_y+max_y)/2}, {2, max_y - min_y}); 
-				}
+				// Contacts are only recorded below, so every other entity gets its box drawn
+				MotionRef motion = registry.motions.get(entity);
+				float min_x = motion.position.x - motion.scale.x / 2;
+				float max_x = motion.position.x + motion.scale.x / 2;
+				float min_y = motion.position.y - motion.scale.y / 2;
+				float max_y = motion.position.y + motion.scale.y / 2;
+				createLine({(min_x+max_x)/2, min_y}, {max_x - min_x, 2}); 
+				createLine({(min_x+max_x)/2, max_y}, {max_x - min_x, 2}); 
+				createLine({min_x, (min_y+max_y)/2}, {2, max_y - min_y}); 
+				createLine({max_x, (min_y+max_y)/2}, {2, max_y - min_y}); 
 			}
 		}
 	}
-	// Check for collisions between all moving entities
+	// Sync point: apply the destructions recorded while moving, before pairs are collected
+	registry.flush_commands();
+
+	// Check for collisions between all moving entities, the broadphase only pairs boxes that share a grid cell
+	// and whose collision filters accept each other
+	auto collision_start = std::chrono::steady_clock::now();
     ComponentContainer<Motion> &motion_container = registry.motions;
-	for(uint i = 0; i<motion_container.components.size(); i++)
+	broadphase.clear();
+	world_shapes.clear();
+	collider_layers.resize(motion_container.size());
+	for(uint i = 0; i<motion_container.size(); i++)
 	{
-		Motion& motion_i = motion_container.components[i];
-		Entity entity_i = motion_container.entities[i];
-		
-		// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-		for(uint j = i+1; j<motion_container.components.size(); j++)
-		{
-			Motion& motion_j = motion_container.components[j];
-			if (collides(motion_i, motion_j))
-			{
-
-				if (motion_i.scale.x != DIAMOND_PROJECTILE_BB_HEIGHT && motion_i.scale.y != DIAMOND_PROJECTILE_BB_HEIGHT && motion_j.scale.x != DIAMOND_PROJECTILE_BB_HEIGHT && motion_j.scale.y != DIAMOND_PROJECTILE_BB_HEIGHT) {
-					// Create a collisions event
-					// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-					registry.collisions.emplace_with_duplicates(entity_i, motion_container.entities[j]);
-					registry.collisions.emplace_with_duplicates(motion_container.entities[j], entity_i);
-				} else if (motion_i.scale.x == DIAMOND_PROJECTILE_BB_HEIGHT && motion_i.scale.y == DIAMOND_PROJECTILE_BB_HEIGHT) {
-					if (vertexCollidesWithBoundingBox(entity_i, motion_j)) {
-						registry.collisions.emplace_with_duplicates(entity_i, motion_container.entities[j]);
-						registry.collisions.emplace_with_duplicates(motion_container.entities[j], entity_i);
-					}
-				} else if (motion_j.scale.x == DIAMOND_PROJECTILE_BB_HEIGHT && motion_j.scale.y == DIAMOND_PROJECTILE_BB_HEIGHT) {
-					if (vertexCollidesWithBoundingBox(motion_container.entities[j], motion_i)) {
-						registry.collisions.emplace_with_duplicates(entity_i, motion_container.entities[j]);
-						registry.collisions.emplace_with_duplicates(motion_container.entities[j], entity_i);
-					}
-				} 
-			}
+		MotionRef motion = motion_container.at(i);
+		Entity entity = motion_container.entities[i];
+		CollisionFilter filter = registry.collisionFilters.has(entity) ? registry.collisionFilters.get(entity) : CollisionFilter();
+		collider_layers[i] = layer_index(filter.layer);
+		// Shape i belongs to Motion row i, its vertices and axes are placed once here for all of its pairs
+		if (registry.colliders.has(entity) && registry.colliders.get(entity).shape != nullptr)
+			world_shapes.add(*registry.colliders.get(entity).shape, motion);
+		else
+			world_shapes.add_box(motion.position, get_bounding_box(motion) / 2.f);
+		broadphase.insert(i, world_shapes.min(i), world_shapes.max(i), filter.layer, filter.mask);
+	}
+	for (auto& counts : layer_pairs)
+		for (size_t& count : counts)
+			count = 0;
+
+	// The cells do not share any state, a job takes a range of them and runs the separating axis test on the pairs
+	// they report. Every job writes to its own buffer, the buffers of the previous step are cleared here because
+	// the pool runs everything as one job when it has no workers.
+	broadphase.build();
+	size_t cell_count = broadphase.cell_count();
+	narrowphase_buffers.resize((cell_count + NARROWPHASE_CELLS - 1) / NARROWPHASE_CELLS);
+	for (NarrowphaseBuffer& buffer : narrowphase_buffers) {
+		buffer.candidates.clear();
+		buffer.contacts.clear();
+		buffer.counts = Broadphase::Counts();
+		buffer.shape_rejects = 0;
+	}
+	jobs.parallel_for(cell_count, NARROWPHASE_CELLS, [&](size_t begin, size_t end) {
+		NarrowphaseBuffer& buffer = narrowphase_buffers[begin / NARROWPHASE_CELLS];
+		for (size_t cell = begin; cell < end; cell++)
+			broadphase.cell_pairs(cell, buffer.candidates, buffer.counts);
+		for (const auto& pair : buffer.candidates) {
+			if (world_shapes.overlap(pair.first, pair.second))
+				buffer.contacts.push_back(pair);
+			else
+				buffer.shape_rejects++;
 		}
+	});
+
+	// Merge the buffers and sort the pairs by Motion row like the loop over all (i,j) pairs used to visit them,
+	// so the contacts come in the same order for any number of threads
+	narrowphase_contacts.clear();
+	broadphase_counts = Broadphase::Counts();
+	shape_rejects = 0;
+	for (const NarrowphaseBuffer& buffer : narrowphase_buffers) {
+		narrowphase_contacts.insert(narrowphase_contacts.end(), buffer.contacts.begin(), buffer.contacts.end());
+		broadphase_counts.tests += buffer.counts.tests;
+		broadphase_counts.filtered += buffer.counts.filtered;
+		shape_rejects += buffer.shape_rejects;
 	}
+	std::sort(narrowphase_contacts.begin(), narrowphase_contacts.end());
+	for (const auto& pair : narrowphase_contacts)
+	{
+		int layer_i = collider_layers[pair.first];
+		int layer_j = collider_layers[pair.second];
+		layer_pairs[std::min(layer_i, layer_j)][std::max(layer_i, layer_j)]++;
+		// Record the contact, the broadphase reports every pair once
+		contacts.add(motion_container.entities[pair.first], motion_container.entities[pair.second], layer_i, layer_j);
+	}
+	collision_time_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - collision_start).count();
+}
+
+void PhysicsSystem::print_collision_stats() const
+{
+	printf("Collision check: %zu boxes, %zu pair tests, %zu pairs filtered by layer, %zu overlapping boxes with separate shapes, %.3f ms on %u threads with the %s kernel\n", broadphase.box_count(), broadphase_counts.tests, broadphase_counts.filtered, shape_rejects, collision_time_ms, jobs.worker_count() + 1, overlap_kernel_name());
+	for (int i = 0; i <= COLLISION_LAYER_COUNT; i++)
+		for (int j = i; j <= COLLISION_LAYER_COUNT; j++)
+			if (layer_pairs[i][j] > 0)
+				printf("  %s - %s: %zu pairs\n", LAYER_NAMES[i], LAYER_NAMES[j], layer_pairs[i][j]);
+	printf("Motion integration: %zu rows with the %s kernel\n", movers.size(), integrate_kernel_name());
+}
+
+void PhysicsSystem::print_flow_field_stats() const
+{
+	const FlowFieldUpdater::Stats& s = flow_field.stats();
+	printf("Flow field: %zu rebuilds, %zu repairs, %zu cells touched, %zu by the last update\n", s.rebuilds, s.repairs, s.cells_touched, s.last_touched);
 }
 
 vec2 PhysicsSystem::findGenieTeleportPosition(vec2 playerPosition, vec2 enemyPosition) {
@@ -488,7 +383,7 @@ vec2 PhysicsSystem::findGenieTeleportPosition(vec2 playerPosition, vec2 enemyPos
 
 		int row = static_cast<int>(candidatePosition.y) / 12;
 		int col = static_cast<int>(candidatePosition.x) / 12;
-		if (row >= 0 && col >= 0 && row < 80 && col < 160 && grid[row][col] == 0) {
+		if (grid.inside(row, col) && grid.get(row, col) == CELL_FLOOR) {
 			return candidatePosition;
 		}
 	}
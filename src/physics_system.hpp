@@ -6,15 +6,52 @@
 #include "tiny_ecs_registry.hpp"
 #include <random>
 #include "grid.hpp"
+#include "motion_integrator.hpp"
+#include "broadphase.hpp"
+#include "collision_shape.hpp"
+#include "flow_field.hpp"
 #include <SDL_mixer.h>
 
+// The contacts of one physics step. They are kept in a flat vector that keeps its capacity between frames,
+// so recording an overlap does not touch the ECS containers. The broadphase reports every pair once, in Motion row order.
+class ContactBuffer
+{
+	std::vector<Contact> pairs;
+	size_t last_frame = 0;
+public:
+	void add(Entity a, Entity b, int layer_a, int layer_b) { pairs.push_back({ a, b, (uint8_t)layer_a, (uint8_t)layer_b }); }
+
+	const Contact& operator[](size_t i) const { return pairs[i]; }
+	size_t size() const { return pairs.size(); }
+	// Number of contacts of the previous frame, before it was cleared
+	size_t last_frame_size() const { return last_frame; }
+	void clear()
+	{
+		last_frame = pairs.size();
+		pairs.clear();
+	}
+};
+
+// Filled by PhysicsSystem::step, handled and cleared by WorldSystem::handle_collisions
+extern ContactBuffer contacts;
+
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
 {
 public:
 	void step(float elapsed_ms);
 	void lerp(float elapsed_ms,float total_ms);
+	// Bring the visibility polygon and the enemy flow field up to date with the player and the walls,
+	// they share no state and may run at the same time
+	void update_visibility();
+	void update_flow_field();
 	vec2 findGenieTeleportPosition(vec2 playerPosition, vec2 enemyPosition);
+	// Boxes, pair tests, pairs whose shapes do not overlap, overlapping pairs by layer combination and time of
+	// the collision check of the last step
+	void print_collision_stats() const;
+	// Rebuilds and repairs of the flow field and the cells they touched since the last reset
+	void print_flow_field_stats() const;
+	void reset_flow_field_stats() { flow_field.reset_stats(); }
 	PhysicsSystem()
 	{
 		rng = std::default_random_engine(std::random_device()());
@@ -25,4 +62,36 @@ private:
 	std::uniform_real_distribution<float> uniform_dist; // number between 0..1
 
 	Mix_Chunk* genie_teleport;
+
+	// Predicted positions of every Motion row this step
+	MotionIntegrator movers;
+
+	// Uniform grid of the bounding boxes, cells about the size of the largest enemies
+	Broadphase broadphase{ 64.f };
+	// Collision shape of every Motion row placed in the world, indexed like the rows
+	WorldShapes world_shapes;
+	// The pairs of Motion rows found by one narrowphase job, every job fills its own
+	struct NarrowphaseBuffer
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> candidates; // overlapping bounds
+		std::vector<std::pair<uint32_t, uint32_t>> contacts; // overlapping shapes
+		Broadphase::Counts counts;
+		size_t shape_rejects = 0;
+	};
+	std::vector<NarrowphaseBuffer> narrowphase_buffers;
+	// The contacts of all buffers, sorted
+	std::vector<std::pair<uint32_t, uint32_t>> narrowphase_contacts;
+	Broadphase::Counts broadphase_counts;
+	float collision_time_ms = 0;
+	// Layer index of every Motion row, and the overlapping pairs found by layer pair, the last index is unfiltered
+	std::vector<int> collider_layers;
+	size_t layer_pairs[COLLISION_LAYER_COUNT + 1][COLLISION_LAYER_COUNT + 1] = {};
+	size_t shape_rejects = 0;
+
+	// Epochs of the last visibility and flow field updates, and the player cell the flow field leads to
+	uint32_t visibility_epoch = 0;
+	uint32_t flow_field_epoch = 0;
+	int flow_field_row = -1;
+	int flow_field_col = -1;
+	FlowFieldUpdater flow_field;
 };
\ No newline at end of file
@@ -10,16 +10,49 @@
 // matrices
 #include <glm/gtc/type_ptr.hpp>
 
+void RenderSystem::save_previous_motions()
+{
+	if (previous_motions.size() < Entity::slot_count())
+		previous_motions.resize(Entity::slot_count());
+	ComponentContainer<Motion>& motions = registry.motions;
+	for (size_t i = 0; i < motions.size(); i++)
+	{
+		Entity entity = motions.entities[i];
+		PreviousMotion& previous = previous_motions[entity.index()];
+		previous.id = entity;
+		previous.position = motions.position[i];
+		previous.angle = motions.angle[i];
+	}
+}
+
+void RenderSystem::interpolate(Entity entity, const MotionRef& motion, vec2& position, float& angle) const
+{
+	position = motion.position;
+	angle = motion.angle;
+	if (interpolation >= 1.f || entity.index() >= previous_motions.size())
+		return;
+	const PreviousMotion& previous = previous_motions[entity.index()];
+	if (previous.id != (unsigned int)entity)
+		return;
+	position = mix(previous.position, motion.position, interpolation);
+	// Turn the short way round
+	float turn = std::remainder(motion.angle - previous.angle, 2.f * (float)M_PI);
+	angle = motion.angle - (1.f - interpolation) * turn;
+}
+
 void RenderSystem::drawTexturedMesh(Entity entity,
 									const mat3 &projection)
 {
-	Motion &motion = registry.motions.get(entity);
+	MotionRef motion = registry.motions.get(entity);
+	vec2 position;
+	float angle;
+	interpolate(entity, motion, position, angle);
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
 	Transform transform;
-	transform.translate(motion.position);
-	transform.rotate(motion.angle);
+	transform.translate(position);
+	transform.rotate(angle);
 	transform.scale(motion.scale);
 	// !!! TODO A1: add rotation to the chain of transformations, mind the order
 	// of transformations
@@ -184,13 +217,16 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 void RenderSystem::drawFloorTexturedMesh(Entity entity,
 									const mat3 &projection)
 {
-	Motion &motion = registry.motions.get(entity);
+	MotionRef motion = registry.motions.get(entity);
+	vec2 position;
+	float angle;
+	interpolate(entity, motion, position, angle);
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
 	Transform transform;
-	transform.translate(motion.position);
-	transform.rotate(motion.angle);
+	transform.translate(position);
+	transform.rotate(angle);
 	transform.scale(motion.scale);
 	// !!! TODO A1: add rotation to the chain of transformations, mind the order
 	// of transformations
@@ -354,11 +390,12 @@ glEnable(GL_BLEND);
 glBlendFunc(GL_ONE, GL_ONE); // Additive blending
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     if (triangleCorners.size() > 0) {
-        Entity player;
-        for (Entity entity : registry.players.entities) {
-            player = entity;
-        }
-        vec2 playerPos = registry.motions.get(player).position;
+        Entity player = registry.single_entity<Player>();
+        // Fan out from where the player is drawn; the corners themselves are
+        // cast once per tick and stay tick-aligned
+        vec2 playerPos;
+        float playerAngle;
+        interpolate(player, registry.motions.get(player), playerPos, playerAngle);
 
         // Prepare visibility triangles
         std::vector<ColoredVertex> visibilityVertices;
@@ -368,20 +405,20 @@ glBlendFunc(GL_ONE, GL_ONE); // Additive blending
 			ColoredVertex vertex1, vertex2, vertex3;
 			constexpr vec3 black = { 1.0,1.0,1.0 };
 			      // Player position in world coordinates
-            vertex1.position = vec3(playerPos.x*2/1920-1, playerPos.y*2/960-1, 0.0f);
+            vertex1.position = vec3(playerPos.x*2/level.width_px()-1, playerPos.y*2/level.height_px()-1, 0.0f);
             vertex1.color = vec3(1.0f, 1.0f, 1.0f);
 
             // Convert the first corner from window to world coordinates
             float winX2 = std::get<1>(triangleCorners[i]);
             float winY2 = std::get<2>(triangleCorners[i]);
-            vertex2.position = vec3(winX2*2/1920-1, winY2*2/960-1, 0.0f);
+            vertex2.position = vec3(winX2*2/level.width_px()-1, winY2*2/level.height_px()-1, 0.0f);
             vertex2.color = vec3(1.0f, 1.0f, 1.0f);
 
             // Convert the second corner from window to world coordinates
             float winX3 = std::get<1>(triangleCorners[i + 1]);
             float winY3 = std::get<2>(triangleCorners[i + 1]);
 
-            vertex3.position =vec3(winX3*2/1920-1, winY3*2/960-1, 0.0f);
+            vertex3.position =vec3(winX3*2/level.width_px()-1, winY3*2/level.height_px()-1, 0.0f);
             vertex3.color = vec3(1.0f, 1.0f, 1.0f);
 
 			// Corner points
@@ -400,8 +437,8 @@ glBlendFunc(GL_ONE, GL_ONE); // Additive blending
 			bindVBOandIBO(GEOMETRY_BUFFER_ID::TRIANGLE, line_vertices, line_indices);
 			    // Set up transformation and projection matrices
 			Transform transform;
-			transform.translate(vec2(960, 480));
-			transform.scale(vec2(960,480));
+			transform.translate(vec2(level.width_px() / 2, level.height_px() / 2));
+			transform.scale(vec2(level.width_px() / 2, level.height_px() / 2));
 			mat3 projection = createProjectionMatrix();
 			glBindVertexArray(vao);
 
@@ -457,20 +494,20 @@ gl_has_errors();
 			ColoredVertex vertex1, vertex2, vertex3;
 			constexpr vec3 black = { 1.0,0.1,1.0 };
 			      // Player position in world coordinates
-            vertex1.position = vec3(playerPos.x*2/1920-1, playerPos.y*2/960-1, 0.0f);
+            vertex1.position = vec3(playerPos.x*2/level.width_px()-1, playerPos.y*2/level.height_px()-1, 0.0f);
             vertex1.color = vec3(1.0f, 1.0f, 1.0f);
 
             // Convert the first corner from window to world coordinates
             float winX2 = std::get<1>(triangleCorners[triangleCorners.size()-1]);
             float winY2 = std::get<2>(triangleCorners[triangleCorners.size()-1]);
-            vertex2.position = vec3(winX2*2/1920-1, winY2*2/960-1, 0.0f);
+            vertex2.position = vec3(winX2*2/level.width_px()-1, winY2*2/level.height_px()-1, 0.0f);
             vertex2.color = vec3(1.0f, 1.0f, 1.0f);
 
             // Convert the second corner from window to world coordinates
             float winX3 = std::get<1>(triangleCorners[0]);
             float winY3 = std::get<2>(triangleCorners[0]);
 
-            vertex3.position =vec3(winX3*2/1920-1, winY3*2/960-1, 0.0f);
+            vertex3.position =vec3(winX3*2/level.width_px()-1, winY3*2/level.height_px()-1, 0.0f);
             vertex3.color = vec3(1.0f, 0.0f, 0.0f);
 
 			// Corner points
@@ -489,8 +526,8 @@ gl_has_errors();
 			bindVBOandIBO(GEOMETRY_BUFFER_ID::TRIANGLE, line_vertices, line_indices);
 			    // Set up transformation and projection matrices
 			Transform transform;
-			transform.translate(vec2(960,480));
-			transform.scale(vec2(960, 480));
+			transform.translate(vec2(level.width_px() / 2, level.height_px() / 2));
+			transform.scale(vec2(level.width_px() / 2, level.height_px() / 2));
 			mat3 projection = createProjectionMatrix();
 			glBindVertexArray(vao);
 
@@ -553,8 +590,8 @@ void RenderSystem::renderSquare(){
     
     // Set up transformation and projection matrices
     Transform transform;
-    transform.translate(vec2(960, 480));
-    transform.scale(vec2(1920, 960));
+    transform.translate(vec2(level.width_px() / 2, level.height_px() / 2));
+    transform.scale(vec2(level.width_px(), level.height_px()));
     mat3 projection = createProjectionMatrix();
     glBindVertexArray(vao);
     
@@ -716,19 +753,10 @@ void RenderSystem::draw(std::string what)
 		// 	drawFloorTexturedMesh(entity, projection_2D);
 		// }
 
-		// Draw all textured meshes that have a position and size component
-		for (Entity entity : registry.renderRequests.entities)
+		// Draw all textured meshes that have a position and size component, in the order they were requested
+		// HUD and home/tutorial screens are drawn separately with their own projection
+		for (Entity entity : registry.view<RenderRequest, Motion>(exclude<HUD, HomeAndTut>).use<RenderRequest>())
 		{
-			if (!registry.motions.has(entity))
-				continue;
-			if (registry.hud.has(entity)) {
-				continue;
-			}
-			if (registry.homeAndTuts.has(entity)) {
-				continue;
-			}
-			// Note, its not very efficient to access elements indirectly via the entity
-			// albeit iterating through all Sprites in sequence. A good point to optimize
 			drawTexturedMesh(entity, projection_2D);
 		}
 
@@ -1029,12 +1057,13 @@ mat3 RenderSystem::createProjectionMatrix()
 	float right = (float) window_width_px;
 	float bottom = (float) window_height_px;
 
-	Motion* player_motion;
-	for (Entity entity : registry.players.entities) {
-		player_motion = &registry.motions.get(entity);	
-	}
-	float offsetX = player_motion->position.x - window_width_px / 2.0f;
-    float offsetY = player_motion->position.y - window_height_px / 2.0f;
+	// The camera follows where the player is drawn
+	Entity player = registry.single_entity<Player>();
+	vec2 player_position;
+	float player_angle;
+	interpolate(player, registry.motions.get(player), player_position, player_angle);
+	float offsetX = player_position.x - window_width_px / 2.0f;
+    float offsetY = player_position.y - window_height_px / 2.0f;
 
 	float sx = 2.f / (right - left);
 	float sy = 2.f / (top - bottom);
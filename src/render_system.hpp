@@ -7,6 +7,7 @@
 #include "components.hpp"
 #include "tiny_ecs.hpp"
 #include "grid.hpp"
+#include "collision_shape.hpp"
 
 #include "ft2build.h"
 #include FT_FREETYPE_H
@@ -121,6 +122,10 @@ class RenderSystem {
 	std::array<GLuint, geometry_count> index_buffers;
 	std::array<Mesh, geometry_count> meshes;
 
+	// Collision shapes from the alpha of every texture and the vertices of every mesh, computed while loading them
+	std::array<CollisionShape, texture_count> texture_shapes;
+	std::array<CollisionShape, geometry_count> mesh_shapes;
+
 public:
 	// Initialize the window
 	bool init(GLFWwindow* window);
@@ -135,6 +140,13 @@ public:
 
 	void initializeGlMeshes();
 	Mesh& getMesh(GEOMETRY_BUFFER_ID id) { return meshes[(int)id]; };
+	// The shape of what a render request draws: the texture of a sprite, otherwise the mesh
+	const CollisionShape& getCollisionShape(const RenderRequest& request) const
+	{
+		if (request.used_geometry == GEOMETRY_BUFFER_ID::SPRITE && request.used_texture != TEXTURE_ASSET_ID::TEXTURE_COUNT)
+			return texture_shapes[(int)request.used_texture];
+		return mesh_shapes[(int)request.used_geometry];
+	}
 
 	void initializeGlGeometryBuffers();
 	// Initialize the screen texture used as intermediate render target
@@ -148,6 +160,11 @@ vec2 windowToWorld(float x, float y);
 	// Draw all entities
 	void draw(std::string what);
 
+	// The simulation advances in fixed ticks, a frame is drawn 'alpha' of the way from the Motions of the previous
+	// tick, saved before every tick, to the current ones. An alpha of 1 draws the current Motions.
+	void save_previous_motions();
+	void set_interpolation(float alpha) { interpolation = alpha; }
+
 	void renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans);
 
 	mat3 createProjectionMatrix();
@@ -205,6 +222,18 @@ vec2 windowToWorld(float x, float y);
 	PurchaseResult transactionSuccessful = PurchaseResult::SUCCESS;
 
 private:
+	// Position and angle of the previous tick, by entity slot index. The id tells whether the slot still holds
+	// the same entity, entities created during the last tick are drawn where they are.
+	struct PreviousMotion
+	{
+		unsigned int id = 0;
+		vec2 position = { 0, 0 };
+		float angle = 0;
+	};
+	std::vector<PreviousMotion> previous_motions;
+	float interpolation = 1.f;
+	void interpolate(Entity entity, const MotionRef& motion, vec2& position, float& angle) const;
+
 	// Internal drawing functions for each entity type
 	void drawTexturedMesh(Entity entity, const mat3& projection);
 	void drawFloorTexturedMesh(Entity entity, const mat3& projection);
@@ -126,8 +126,6 @@ void RenderSystem::initializeBackgroundQuad()
     vertices[3].texcoord = { 0.f, 10.f }; // Adjust the number of repetitions as needed
 
     const std::vector<uint16_t> indices = { 0, 1, 2, 2, 3, 0 };
-	meshes[(int)GEOMETRY_BUFFER_ID::DIAMOND].vertices = std::vector<ColoredVertex>{{vertices[0].position, { 0.8, 0.8, 0.8 }},{vertices[1].position, { 0.8, 0.8, 0.8 }},{vertices[2].position, { 0.8, 0.8, 0.8 }},{vertices[3].position, { 0.8, 0.8, 0.8 }}};
-	meshes[(int)GEOMETRY_BUFFER_ID::DIAMOND].vertex_indices = indices;
 
     bindVBOandIBO(GEOMETRY_BUFFER_ID::BACKGROUND, vertices, indices);
 }
@@ -152,6 +150,7 @@ void RenderSystem::initializeGlTextures()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         gl_has_errors();
 
+        texture_shapes[i] = shape_from_alpha(data, width, height);
         stbi_image_free(data);
     }
 }
@@ -343,6 +342,17 @@ void RenderSystem::initializeGlGeometryBuffers()
 	// Counterclockwise as it's the default opengl front winding direction.
 	const std::vector<uint16_t> screen_indices = { 0, 1, 2 };
 	bindVBOandIBO(GEOMETRY_BUFFER_ID::SCREEN_TRIANGLE, screen_vertices, screen_indices);
+
+	// Collision shapes of the meshes with vertices, the others keep the whole quad
+	for (int i = 0; i < geometry_count; i++)
+	{
+		if (meshes[i].vertices.empty())
+			continue;
+		std::vector<vec2> points;
+		for (const ColoredVertex& vertex : meshes[i].vertices)
+			points.push_back({ vertex.position.x, vertex.position.y });
+		mesh_shapes[i] = shape_from_points(points);
+	}
 }
 
 void RenderSystem::initializeHUDGeometry()
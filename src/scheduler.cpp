@@ -0,0 +1,139 @@
+// internal
+#include "scheduler.hpp"
+
+#include <stdio.h>
+#include <assert.h>
+
+void Scheduler::add(const std::string& name, uint64_t reads, uint64_t writes, std::function<void()> run)
+{
+	System system;
+	system.name = name;
+	system.reads = reads;
+	system.writes = writes;
+	system.run = run;
+	all.push_back(system);
+}
+
+void Scheduler::add(const std::string& name, uint64_t reads, uint64_t writes, uint64_t resource_reads, uint64_t resource_writes,
+	std::function<void()> run)
+{
+	add(name, reads, writes, run);
+	all.back().resource_reads = resource_reads;
+	all.back().resource_writes = resource_writes;
+}
+
+void Scheduler::add_exclusive(const std::string& name, std::function<void()> run)
+{
+	add(name, 0, 0, run);
+	all.back().exclusive = true;
+}
+
+void Scheduler::add_main_thread(const std::string& name, uint64_t reads, uint64_t writes, std::function<void()> run)
+{
+	add(name, reads, writes, run);
+	all.back().main_thread = true;
+}
+
+uint64_t Scheduler::resource(const std::string& name)
+{
+	for (size_t bit = 0; bit < resources.size(); bit++)
+		if (resources[bit] == name)
+			return uint64_t(1) << bit;
+	assert(resources.size() < 64);
+	resources.push_back(name);
+	return uint64_t(1) << (resources.size() - 1);
+}
+
+bool Scheduler::conflict(const System& a, const System& b) const
+{
+	if (a.exclusive || b.exclusive)
+		return true;
+	bool components = (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+	bool global = (a.resource_writes & (b.resource_reads | b.resource_writes)) != 0 || (b.resource_writes & a.resource_reads) != 0;
+	return components || global;
+}
+
+void Scheduler::build_graph()
+{
+	if (nodes.size() != all.size())
+	{
+		nodes.clear();
+		for (size_t i = 0; i < all.size(); i++)
+			nodes.emplace_back(new Node);
+	}
+	for (size_t later = 0; later < all.size(); later++)
+	{
+		nodes[later]->successors.clear();
+		nodes[later]->waiting_for = 0;
+		for (size_t earlier = 0; earlier < later; earlier++)
+		{
+			if (conflict(all[earlier], all[later]))
+			{
+				nodes[earlier]->successors.push_back(later);
+				nodes[later]->waiting_for++;
+			}
+		}
+	}
+}
+
+void Scheduler::run()
+{
+	build_graph();
+	frame_start = std::chrono::steady_clock::now();
+	for (size_t system = 0; system < all.size(); system++)
+		if (!on_caller(system) && nodes[system]->waiting_for == 0)
+			launch(system);
+
+	// Edges only point to later systems, so once the calling thread reaches a system in order all of its
+	// predecessors are done: queued systems have been launched, and exclusive and main thread ones can run here.
+	// Waiting runs queued jobs on this thread too.
+	for (size_t system = 0; system < all.size(); system++)
+	{
+		if (on_caller(system))
+		{
+			execute(system);
+			release(system);
+		}
+		else
+			jobs.wait(nodes[system]->done);
+	}
+	frame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+}
+
+void Scheduler::launch(size_t system)
+{
+	JobPool::Group& done = nodes[system]->done;
+	jobs.run(done, [this, system]() { execute(system); });
+	jobs.then(done, [this, system]() { release(system); });
+}
+
+void Scheduler::execute(size_t system)
+{
+	auto start = std::chrono::steady_clock::now();
+	all[system].run();
+	auto end = std::chrono::steady_clock::now();
+	all[system].started_ms = std::chrono::duration<float, std::milli>(start - frame_start).count();
+	all[system].finished_ms = std::chrono::duration<float, std::milli>(end - frame_start).count();
+}
+
+void Scheduler::release(size_t system)
+{
+	for (size_t next : nodes[system]->successors)
+		if (--nodes[next]->waiting_for == 0 && !on_caller(next))
+			launch(next);
+}
+
+float Scheduler::busy_ms() const
+{
+	float busy = 0;
+	for (const System& system : all)
+		busy += system.finished_ms - system.started_ms;
+	return busy;
+}
+
+void Scheduler::print_timings() const
+{
+	printf("Frame %.2f ms, systems busy %.2f ms:\n", frame, busy_ms());
+	for (const System& system : all)
+		printf("  %-24s %7.2f - %7.2f ms\n", system.name.c_str(), system.started_ms, system.finished_ms);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+#include "job_pool.hpp"
+
+// Runs the systems of a frame as jobs of the job pool.
+// Every system declares the component containers it reads and writes as signature masks (see Registry::mask),
+// and the global state outside the registry it reads and writes as resource masks (see resource()).
+// Each frame the scheduler orders a system after every earlier added system it conflicts with, that is one
+// writes what the other reads or writes, and lets systems without a path between them run at the same time.
+// Systems that create or destroy entities change the shared entity slots and run alone, on the calling thread.
+// Every system runs in its own job group, and a continuation of that group queues the successors it unblocked.
+class Scheduler
+{
+public:
+	struct System
+	{
+		std::string name;
+		uint64_t reads = 0;
+		uint64_t writes = 0;
+		uint64_t resource_reads = 0;
+		uint64_t resource_writes = 0;
+		bool exclusive = false; // creates or destroys entities
+		bool main_thread = false; // must run on the thread that calls run(), e.g. because it uses the OpenGL context
+		std::function<void()> run;
+
+		// Timings of the last frame, in ms since the frame started
+		float started_ms = 0;
+		float finished_ms = 0;
+	};
+
+	// Systems are added in the order they would run sequentially, conflicting systems keep that order
+	void add(const std::string& name, uint64_t reads, uint64_t writes, std::function<void()> run);
+	void add(const std::string& name, uint64_t reads, uint64_t writes, uint64_t resource_reads, uint64_t resource_writes,
+		std::function<void()> run);
+	void add_exclusive(const std::string& name, std::function<void()> run);
+	void add_main_thread(const std::string& name, uint64_t reads, uint64_t writes, std::function<void()> run);
+
+	// The mask bit of a piece of global state, e.g. the level's distance field, given out on the first use of the name
+	uint64_t resource(const std::string& name);
+
+	// Run every system once and wait for all of them
+	void run();
+
+	const std::vector<System>& systems() const { return all; }
+	// Wall time of the last frame, and the sum of the system times, which is larger when systems overlapped
+	float frame_ms() const { return frame; }
+	float busy_ms() const;
+	void print_timings() const;
+
+private:
+	std::vector<System> all;
+	std::vector<std::string> resources; // by bit
+	struct Node
+	{
+		JobPool::Group done; // the system's job and the continuation that releases its successors
+		std::atomic<int> waiting_for{ 0 }; // number of unfinished predecessors
+		std::vector<size_t> successors;
+	};
+	std::vector<std::unique_ptr<Node>> nodes; // by system, rebuilt every frame
+	std::chrono::steady_clock::time_point frame_start;
+	float frame = 0;
+
+	bool conflict(const System& a, const System& b) const;
+	// Exclusive and main thread systems are not queued, the calling thread of run() runs them in order
+	bool on_caller(size_t system) const { return all[system].exclusive || all[system].main_thread; }
+	void build_graph();
+	void launch(size_t system);
+	void execute(size_t system);
+	// Count the system as finished for its successors and queue the ones that have no predecessors left
+	void release(size_t system);
+};
@@ -0,0 +1,165 @@
+// internal
+#include "tile_sweep.hpp"
+#include "grid.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Distance kept between a box and the wall it stopped at, so that it does not cover the wall tile
+const float SKIN = 0.01f;
+// Rounding tolerance: a box edge that trails or stands still must be this far into a tile to cover it,
+// a leading edge covers the tile it is about to enter
+const float TOUCH = 0.001f;
+
+static bool is_wall(int row, int col)
+{
+	return !grid.inside(row, col) || grid.get(row, col) == CELL_WALL;
+}
+
+// The first of the tiles [first, last] across the walk that is a wall, or last + 1. Along x they are a column,
+// along y a row segment whose words are searched at once.
+static int first_wall(bool along_x, int tile, int first, int last)
+{
+	if (along_x)
+	{
+		for (int across = first; across <= last; across++)
+			if (is_wall(across, tile))
+				return across;
+		return last + 1;
+	}
+	if (tile < 0 || tile >= level.height() || first < 0)
+		return first;
+	int col = grid.first_in_row(tile, first, std::min(last, level.width() - 1), CELLS_WALL);
+	if (col >= 0)
+		return col;
+	return last >= level.width() ? level.width() : last + 1;
+}
+
+// The tiles [first, last] a box moving by 'move' covers on one axis, a box that ends on a tile border does not
+// cover the next tile
+static void tile_span(float min, float max, float move, int& first, int& last)
+{
+	first = (int)std::floor((min + (move < 0 ? -TOUCH : TOUCH)) / TILE_SIZE);
+	last = std::max(first, (int)std::ceil((max + (move > 0 ? TOUCH : -TOUCH)) / TILE_SIZE) - 1);
+}
+
+// The walk along one axis: the next tile the leading edge enters and the fraction of the move when it does
+struct AxisWalk
+{
+	int step = 0; // 1, -1 or 0 when the box does not move along this axis
+	int tile = 0;
+	float next = std::numeric_limits<float>::infinity();
+	float per_tile = std::numeric_limits<float>::infinity();
+};
+
+static AxisWalk start_walk(float center, float half_size, float move)
+{
+	AxisWalk walk;
+	if (move > 0)
+	{
+		float lead = center + half_size;
+		walk.step = 1;
+		walk.tile = (int)std::ceil(lead / TILE_SIZE);
+		walk.next = (walk.tile * TILE_SIZE - lead) / move;
+		walk.per_tile = TILE_SIZE / move;
+	}
+	else if (move < 0)
+	{
+		float lead = center - half_size;
+		walk.step = -1;
+		walk.tile = (int)std::floor(lead / TILE_SIZE) - 1;
+		walk.next = (lead - (walk.tile + 1) * TILE_SIZE) / -move;
+		walk.per_tile = TILE_SIZE / -move;
+	}
+	return walk;
+}
+
+TileHit sweep_tiles(vec2 position, vec2 half_size, vec2 delta)
+{
+	TileHit result;
+	result.position = position + delta;
+	if (!std::isfinite(position.x) || !std::isfinite(position.y) || !std::isfinite(delta.x) || !std::isfinite(delta.y))
+		return result;
+
+	AxisWalk x = start_walk(position.x, half_size.x, delta.x);
+	AxisWalk y = start_walk(position.y, half_size.y, delta.y);
+	while (true)
+	{
+		bool along_x = x.next <= y.next;
+		AxisWalk& walk = along_x ? x : y;
+		AxisWalk& other = along_x ? y : x;
+		float t = walk.next;
+		if (!(t <= 1.f))
+			break;
+
+		// The entered column (or row) is checked where the box covers it at that moment. When the other edge
+		// enters a tile at the same moment, that tile counts too, otherwise a box moving into a corner would pass it.
+		vec2 at = position + delta * t;
+		int first, last;
+		if (along_x)
+			tile_span(at.y - half_size.y, at.y + half_size.y, delta.y, first, last);
+		else
+			tile_span(at.x - half_size.x, at.x + half_size.x, delta.x, first, last);
+		if (other.next <= t)
+		{
+			first = std::min(first, other.tile);
+			last = std::max(last, other.tile);
+		}
+
+		int across = first_wall(along_x, walk.tile, first, last);
+		if (across <= last)
+		{
+			int row = along_x ? across : walk.tile;
+			int col = along_x ? walk.tile : across;
+
+			// Stop just before the border of the wall tile
+			float border = (walk.step > 0 ? walk.tile : walk.tile + 1) * TILE_SIZE;
+			float stop = border - walk.step * (along_x ? half_size.x : half_size.y) - walk.step * SKIN;
+			result.hit = true;
+			result.toi = t;
+			result.row = row;
+			result.col = col;
+			if (along_x)
+			{
+				result.normal = { (float)-walk.step, 0.f };
+				result.position = { stop, at.y };
+			}
+			else
+			{
+				result.normal = { 0.f, (float)-walk.step };
+				result.position = { at.x, stop };
+			}
+			return result;
+		}
+		walk.tile += walk.step;
+		walk.next += walk.per_tile;
+	}
+	return result;
+}
+
+TileMove slide_tiles(vec2 position, vec2 half_size, vec2 delta)
+{
+	TileMove move;
+	move.position = position;
+	// A wall blocks one axis, the second sweep moves the rest along the other one and may be blocked too
+	for (int sweep = 0; sweep < 2; sweep++)
+	{
+		TileHit hit = sweep_tiles(move.position, half_size, delta);
+		move.position = hit.position;
+		if (!hit.hit)
+			break;
+		delta *= 1.f - hit.toi;
+		if (hit.normal.x != 0)
+		{
+			move.hit_x = true;
+			delta.x = 0;
+		}
+		else
+		{
+			move.hit_y = true;
+			delta.y = 0;
+		}
+	}
+	return move;
+}
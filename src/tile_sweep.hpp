@@ -0,0 +1,31 @@
+#pragma once
+
+#include "common.hpp"
+#include "grid.hpp"
+
+// Where a box moving through the grid first touches a wall tile
+struct TileHit
+{
+	bool hit = false;
+	float toi = 1.f; // fraction of the move done before the contact, 1 without a hit
+	vec2 normal = { 0, 0 }; // points out of the wall, along x or y
+	vec2 position = { 0, 0 }; // center of the box at the contact, or at the end of the move
+	int row = -1;
+	int col = -1;
+};
+
+// Sweeps a box with half size 'half_size' from 'position' by 'delta' through the wall tiles of the grid.
+// The tiles are visited in the order the leading edges of the box enter them (a DDA walk), so a long move
+// cannot skip a wall. Tiles outside the level count as walls, tiles the box already overlaps are ignored.
+TileHit sweep_tiles(vec2 position, vec2 half_size, vec2 delta);
+
+// The result of moving a box along the walls
+struct TileMove
+{
+	vec2 position = { 0, 0 };
+	bool hit_x = false; // the move was blocked along x
+	bool hit_y = false;
+};
+
+// Moves a box like sweep_tiles and slides along the first wall it touches with the rest of the move
+TileMove slide_tiles(vec2 position, vec2 half_size, vec2 delta);
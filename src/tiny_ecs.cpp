@@ -1,5 +1,100 @@
 // internal
 #include "tiny_ecs.hpp"
 
-// All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+// All we need to store besides the containers is the generation of every entity slot and the recycled slots
+std::vector<unsigned int> Entity::generations = { 0 }; // slot 0 is reserved, entity 0 is the null entity
+std::deque<unsigned int> Entity::free_slots;
+
+unsigned int Entity::create()
+{
+	unsigned int index;
+	if (free_slots.size() > MIN_FREE_SLOTS)
+	{
+		index = free_slots.front();
+		free_slots.pop_front();
+	}
+	else
+	{
+		index = (unsigned int)generations.size();
+		assert(index <= INDEX_MASK && "Ran out of entity slots");
+		generations.push_back(0);
+	}
+	return (generations[index] << INDEX_BITS) | index;
+}
+
+void Entity::destroy(Entity e)
+{
+	if (!valid(e))
+		return;
+	unsigned int index = e.index();
+	generations[index] = (generations[index] + 1) & GENERATION_MASK;
+	free_slots.push_back(index);
+}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+void ArchetypeStorage::update(const std::vector<uint64_t>& signatures)
+{
+	if (iterating > 0)
+		return; // picked up by the next view
+	for (Entity e : dirty)
+	{
+		unsigned int index = e.index();
+		if (index >= locations.size())
+			locations.resize(index + 1, { NOWHERE, 0, 0 });
+		bool alive = Entity::valid(e);
+		uint64_t signature = (alive && index < signatures.size()) ? signatures[index] : 0;
+
+		Location at = locations[index];
+		if (at.archetype != NOWHERE)
+		{
+			uint32_t stored = archetypes[at.archetype].chunks[at.chunk]->rows[at.row];
+			if (!alive && stored != (unsigned int)e)
+				continue; // an older handle of a slot that was recycled since
+			if (stored == (unsigned int)e && archetypes[at.archetype].signature == signature)
+				continue; // already in the right place
+			detach(index);
+		}
+		if (alive && signature != 0)
+			attach(e, signature);
+	}
+	dirty.clear();
+}
+
+void ArchetypeStorage::attach(Entity e, uint64_t signature)
+{
+	auto found = archetype_of_signature.find(signature);
+	uint32_t a;
+	if (found == archetype_of_signature.end())
+	{
+		a = (uint32_t)archetypes.size();
+		archetypes.push_back({ signature, {} });
+		archetype_of_signature[signature] = a;
+	}
+	else
+		a = found->second;
+
+	Archetype& archetype = archetypes[a];
+	if (archetype.chunks.empty() || archetype.chunks.back()->count == Chunk::CAPACITY)
+		archetype.chunks.emplace_back(new Chunk);
+	Chunk& chunk = *archetype.chunks.back();
+	chunk.rows[chunk.count] = e;
+	locations[e.index()] = { a, (uint32_t)archetype.chunks.size() - 1, chunk.count };
+	chunk.count++;
+}
+
+void ArchetypeStorage::detach(unsigned int index)
+{
+	Location at = locations[index];
+	Archetype& archetype = archetypes[at.archetype];
+	Chunk& last = *archetype.chunks.back();
+
+	// Fill the hole with the last row of the archetype to keep the chunks packed
+	uint32_t moved = last.rows[last.count - 1];
+	archetype.chunks[at.chunk]->rows[at.row] = moved;
+	locations[Entity(moved).index()] = at;
+	last.count--;
+	if (last.count == 0)
+		archetype.chunks.pop_back();
+	locations[index].archetype = NOWHERE;
+}
+#endif
@@ -1,50 +1,379 @@
 #pragma once
 
 #include <algorithm>
+#include <deque>
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <new>
 #include <set>
 #include <functional>
+#include <tuple>
+#include <initializer_list>
 #include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <stdio.h>
+#include <stdint.h>
 #include <assert.h>
 
 // Unique identifyer for all entities
+// The id packs a slot index (low INDEX_BITS) and a generation (high bits). Destroyed slots are
+// recycled with a bumped generation, so handles to a destroyed entity are detected by valid().
 class Entity
 {
 	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
+	static std::vector<unsigned int> generations; // current generation per slot, slot 0 is the null entity
+	static std::deque<unsigned int> free_slots; // destroyed slots waiting to be recycled
+	static unsigned int create();
 public:
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+	// Slots are only reused once this many are free, so a single slot's generation wraps slowly
+	static const unsigned int MIN_FREE_SLOTS = 1024;
+
 	Entity()
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		id = create();
+	}
+	// Wraps an existing handle, does not create a new entity
+	explicit Entity(unsigned int handle) : id(handle) {}
+	// A handle that never refers to a live entity
+	static Entity null() { return Entity(0u); }
+
+	unsigned int index() const { return id & INDEX_MASK; }
+	unsigned int generation() const { return id >> INDEX_BITS; }
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+
+	// Check that the entity has not been destroyed since the handle was created
+	static bool valid(Entity e)
+	{
+		unsigned int i = e.index();
+		return i != 0 && i < generations.size() && generations[i] == e.generation();
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
+	// Invalidate all handles to e and put its slot on the free list, destroying twice is a no-op
+	static void destroy(Entity e);
+	// Number of slots ever handed out, bounds any array indexed by Entity::index()
+	static size_t slot_count() { return generations.size(); }
+	// Make room for n more slots so creating them does not allocate
+	static void reserve(size_t n) { generations.reserve(generations.size() + n); }
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+#ifdef ECS_ARCHETYPE_STORAGE
+// Archetype storage mode (CMake option ECS_ARCHETYPE_STORAGE): entities with exactly the same
+// component signature are grouped into fixed-size 16 KB chunks of entity handles, and views walk
+// the chunks of the matching archetypes instead of probing every container for every entity.
+// Component data stays in the per-type containers, so a reference returned by emplace() stays
+// valid while the factories keep adding components to the same entity.
+// Regrouping is lazy: signature changes are queued and applied by update() when a view is created.
+class ArchetypeStorage
 {
-	virtual void clear() = 0;
-	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+public:
+	static const size_t CHUNK_BYTES = 16 * 1024;
+	struct Chunk
+	{
+		static const uint32_t CAPACITY = (CHUNK_BYTES - sizeof(uint32_t)) / sizeof(uint32_t);
+		uint32_t count = 0;
+		uint32_t rows[CAPACITY]; // entity handles
+	};
+	struct Archetype
+	{
+		uint64_t signature;
+		std::vector<std::unique_ptr<Chunk>> chunks;
+	};
+
+	// Queue an entity whose signature changed
+	void mark(Entity e) { dirty.push_back(e); }
+	// Move the queued entities to the archetype of their current signature
+	void update(const std::vector<uint64_t>& signatures);
+
+	// Calls fn(rows, count) for every chunk of every archetype that has all 'include' and none of the 'exclude' bits
+	template <typename Fn>
+	void each_chunk(uint64_t include, uint64_t exclude, Fn fn)
+	{
+		iterating++;
+		for (size_t a = 0; a < archetypes.size(); a++)
+		{
+			uint64_t signature = archetypes[a].signature;
+			if ((signature & include) != include || (signature & exclude) != 0)
+				continue;
+			for (size_t c = 0; c < archetypes[a].chunks.size(); c++)
+				fn(archetypes[a].chunks[c]->rows, archetypes[a].chunks[c]->count);
+		}
+		iterating--;
+	}
+
+	size_t archetype_count() const { return archetypes.size(); }
+
+private:
+	struct Location { uint32_t archetype, chunk, row; };
+	static const uint32_t NOWHERE = ~0u;
+
+	std::vector<Archetype> archetypes;
+	std::unordered_map<uint64_t, uint32_t> archetype_of_signature;
+	std::vector<Location> locations; // by entity slot index
+	std::vector<Entity> dirty;
+	int iterating = 0; // chunks must not change while a view walks them
+
+	void attach(Entity e, uint64_t signature);
+	void detach(unsigned int index);
+};
+#endif
+
+// Data shared by all containers in the ECS registry
+struct ContainerBase
+{
+	unsigned int id = 0; // position in the registry's type list, assigned when the registry is constructed
+	std::vector<uint64_t>* signatures = nullptr; // per-entity bitmask of containers holding it, bit 'id' is ours
+#ifdef ECS_ARCHETYPE_STORAGE
+	ArchetypeStorage* archetypes = nullptr; // set together with signatures
+#endif
+
+	// Change tracking, opt-in with track_changes(). Inserting, removing and patch() record the entity
+	// with the current epoch, which the registry advances once per frame (see Registry::next_epoch).
+	bool tracking = false;
+	uint32_t epoch = 1;
+	uint32_t last_modified_epoch = 0;
+	std::vector<uint32_t> modified_epochs; // by entity slot index, the last epoch the entity changed in
+	std::vector<Entity> modified_entities; // changed in the current epoch, each entity once
+
+	size_t growths = 0; // reallocations of the storage since the last Registry::report_growth()
+
+	void track_changes(bool enable = true) { tracking = enable; }
+
+	void mark_modified(Entity e)
+	{
+		if (!tracking)
+			return;
+		unsigned int index = e.index();
+		if (index >= modified_epochs.size())
+			modified_epochs.resize(index + 1, 0);
+		if (modified_epochs[index] != epoch)
+			modified_entities.push_back(e);
+		modified_epochs[index] = epoch;
+		last_modified_epoch = epoch;
+	}
+
+	// Entities added, removed or patched in the current epoch, check has() before using their component
+	const std::vector<Entity>& modified() const { return modified_entities; }
+
+	// Did e or any entity change in epoch 'since' or later, always true when changes are not tracked.
+	// A system that stores the epoch it last ran in also sees changes made after it ran in that epoch.
+	bool modified_since(Entity e, uint32_t since) const
+	{
+		return !tracking || (e.index() < modified_epochs.size() && modified_epochs[e.index()] >= since);
+	}
+	bool modified_since(uint32_t since) const
+	{
+		return !tracking || last_modified_epoch >= since;
+	}
+
+	void set_signature_bit(Entity e)
+	{
+		if (signatures == nullptr)
+			return;
+		if (e.index() >= signatures->size())
+			signatures->resize(e.index() + 1, 0);
+		(*signatures)[e.index()] |= uint64_t(1) << id;
+#ifdef ECS_ARCHETYPE_STORAGE
+		archetypes->mark(e);
+#endif
+		mark_modified(e);
+	}
+	void clear_signature_bit(Entity e)
+	{
+		if (signatures != nullptr && e.index() < signatures->size())
+		{
+			(*signatures)[e.index()] &= ~(uint64_t(1) << id);
+#ifdef ECS_ARCHETYPE_STORAGE
+			archetypes->mark(e);
+#endif
+		}
+		mark_modified(e);
+	}
+};
+
+// Allocator that hands out memory aligned for SIMD loads, 32 bytes covers AVX
+template <typename T, size_t Alignment = 32>
+struct AlignedAllocator
+{
+	using value_type = T;
+	template <typename U>
+	struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+	AlignedAllocator() = default;
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+	void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+	template <typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template <typename U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// The allocator of the 'components' array of a ComponentContainer<Component>, defaults to std::allocator.
+// Only that array uses it: the entity list, the sparse pages and the change lists stay on the default allocator,
+// and the column storage of Motion (see components.hpp) ignores it. Reserving per wave is what keeps spawns from allocating.
+template <typename Component>
+struct ComponentAllocator
+{
+	using type = std::allocator<Component>;
+};
+
+// The sparse set behind ComponentContainer: 'entities' is a tightly packed (dense) array, and a paged sparse array
+// maps an entity slot index to its position (row) in it. Derived containers keep their component data in the same rows.
+class SparseSet : public ContainerBase
+{
+protected:
+	// The sparse array is split into pages so that large slot indices do not force one huge allocation.
+	// Pages are only allocated once an entity in their index range receives this component.
+	static const unsigned int SPARSE_PAGE_SIZE = 1024;
+	static const unsigned int INVALID_INDEX = ~0u;
+	std::vector<std::unique_ptr<unsigned int[]>> sparse_pages;
+	bool sorting = false; // the comparison function of sort() may still look up components
+
+	// Returns the dense index slot for entity e, allocating its page on demand
+	unsigned int& sparse_slot(Entity e)
+	{
+		unsigned int id = e.index();
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size() || !sparse_pages[page])
+		{
+			allocate_page(page);
+			growths++;
+		}
+		return sparse_pages[page][id % SPARSE_PAGE_SIZE];
+	}
+
+	void allocate_page(unsigned int page)
+	{
+		if (page >= sparse_pages.size())
+			sparse_pages.resize(page + 1);
+		if (!sparse_pages[page])
+		{
+			sparse_pages[page].reset(new unsigned int[SPARSE_PAGE_SIZE]);
+			for (unsigned int i = 0; i < SPARSE_PAGE_SIZE; i++)
+				sparse_pages[page][i] = INVALID_INDEX;
+		}
+	}
+
+	// Returns the dense index of entity e, or INVALID_INDEX, without allocating
+	unsigned int dense_index(Entity e) const
+	{
+		unsigned int id = e.index();
+		unsigned int page = id / SPARSE_PAGE_SIZE;
+		if (page >= sparse_pages.size() || !sparse_pages[page])
+			return INVALID_INDEX;
+		return sparse_pages[page][id % SPARSE_PAGE_SIZE];
+	}
+
+	// Append e as the last row, the derived container appends its data to the same row
+	void push_row(Entity e)
+	{
+		sparse_slot(e) = (unsigned int)entities.size();
+		entities.push_back(e);
+	}
+
+	// Move the last row into 'row', the row of e, and drop the last one.
+	// The derived container has already done the same with its data.
+	void remove_row(Entity e, unsigned int row)
+	{
+		entities[row] = entities.back(); // the entity is only a single index, copy it.
+		sparse_slot(entities.back()) = row;
+		sparse_slot(e) = INVALID_INDEX;
+		clear_signature_bit(e);
+		entities.pop_back();
+	}
+
+	void clear_rows()
+	{
+		// Only the pages touched by current entities hold valid indices, reset those instead of freeing every page
+		for (Entity e : entities)
+		{
+			sparse_slot(e) = INVALID_INDEX;
+			clear_signature_bit(e);
+		}
+		entities.clear();
+	}
+
+	// Make room for n rows in total, including the sparse pages of the entity slots created next
+	void reserve_rows(size_t n)
+	{
+		entities.reserve(n);
+		if (n > entities.size())
+		{
+			size_t first = Entity::slot_count();
+			size_t last = first + (n - entities.size()) - 1;
+			for (size_t page = first / SPARSE_PAGE_SIZE; page <= last / SPARSE_PAGE_SIZE; page++)
+				allocate_page((unsigned int)page);
+		}
+	}
+
+	// Sort the entity list by the comparisonFunction, see std::sort, and move the data along with swap_rows(a, b)
+	template <class Compare, class SwapRows>
+	void sort_rows(Compare comparisonFunction, SwapRows swap_rows)
+	{
+		// First sort the entity list as desired
+		sorting = true;
+		std::sort(entities.begin(), entities.end(), comparisonFunction);
+		sorting = false;
+		// Now re-arrange the data in place, without allocating: the data that belongs at i
+		// is still at the old position of entities[i], which the sparse array holds until we update it.
+		// Following each cycle of this permutation with swaps puts every row in place exactly once,
+		// and updating the sparse slot as we go marks it as done.
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			unsigned int current = i;
+			unsigned int next = dense_index(entities[current]);
+			while (next != i)
+			{
+				swap_rows(current, next);
+				sparse_slot(entities[current]) = current;
+				current = next;
+				next = dense_index(entities[current]);
+			}
+			sparse_slot(entities[current]) = current;
+		}
+	}
+
+public:
+	// The entities of the rows
+	std::vector<Entity> entities;
+
+	// Check if entity has a component of type 'Component'
+	bool has(Entity entity) {
+		unsigned int cID = dense_index(entity);
+		// comparing the full handle rejects stale handles whose slot was recycled,
+		// while sorting the entities are shuffled and only the sparse slot is meaningful
+		if (sorting)
+			return cID != INVALID_INDEX;
+		return cID < entities.size() && entities[cID] == entity;
+	}
+
+	// Report the number of components
+	size_t size()
+	{
+		return entities.size();
+	}
 };
 
 // A container that stores components of type 'Component' and associated entities
-template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+// Storage is a sparse set: 'components' and 'entities' are tightly packed (dense) arrays,
+// and a paged sparse array maps an entity slot index to its position in the dense arrays.
+// Empty types (tags like Boid or HUD) carry no data and use TagContainer instead, see below.
+template <typename Component, bool IsTag = std::is_empty<Component>::value,
+	typename Allocator = typename ComponentAllocator<Component>::type> // A component can be any class
+class ComponentContainer : public SparseSet
 {
-private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
-	bool registered = false;
 public:
 	// Container of all components of type 'Component'
-	std::vector<Component> components;
-
-	// The corresponding entities
-	std::vector<Entity> entities;
+	std::vector<Component, Allocator> components;
 
 	// Constructor that registers the type
 	ComponentContainer()
@@ -57,9 +386,12 @@ public:
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		size_t capacity = components.capacity();
+		push_row(e);
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
-		entities.push_back(e);
+		if (components.capacity() != capacity)
+			growths++;
+		set_signature_bit(e);
 		return components.back();
 	};
 
@@ -76,12 +408,15 @@ public:
 	// A wrapper to return the component of an entity
 	Component& get(Entity e) {
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return components[dense_index(e)];
 	}
 
-	// Check if entity has a component of type 'Component'
-	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+	// Modify the component of e through fn(component&) and record the change for systems that track it
+	template <typename Fn>
+	void patch(Entity e, Fn fn)
+	{
+		fn(get(e));
+		mark_modified(e);
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -90,48 +425,541 @@ public:
 		if (has(e))
 		{
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			unsigned int cID = dense_index(e);
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
-			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
-
-			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
 			components.pop_back();
-			entities.pop_back();
-			// Note, one could mark the id for re-use
+			remove_row(e, cID);
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		clear_rows();
 		components.clear();
+	}
+
+	// Make room for n components in total, including the sparse pages of the entity slots created next,
+	// so inserting up to n components does not allocate
+	void reserve(size_t n)
+	{
+		reserve_rows(n);
+		components.reserve(n);
+	}
+
+	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	template <class Compare>
+	void sort(Compare comparisonFunction)
+	{
+		sort_rows(comparisonFunction, [this](unsigned int a, unsigned int b) { std::swap(components[a], components[b]); });
+	}
+};
+
+// A container for empty tag components: membership is one bit per entity slot, so has() is a single bit read,
+// and the tagged entities are kept in a packed list for iteration, with each slot's position in it for swap-and-pop removal.
+// There is no per-entity component data, get() hands out the same instance for every entity.
+template <typename Component>
+class TagContainer : public ContainerBase
+{
+private:
+	std::vector<uint64_t> bits; // by entity slot index
+	std::vector<unsigned int> dense; // position in entities by entity slot index, valid where the bit is set
+	Component instance;
+
+	void grow_slots(size_t words)
+	{
+		bits.resize(words, 0);
+		dense.resize(words * 64);
+	}
+
+public:
+	// The tagged entities
+	std::vector<Entity> entities;
+
+	// Tag an entity, a tag can only be set once so duplicates are ignored
+	inline Component& insert(Entity e, Component = {}, bool check_for_duplicates = true)
+	{
+		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+		if (has(e))
+			return instance;
+
+		unsigned int id = e.index();
+		size_t capacity = entities.capacity();
+		if (id / 64 >= bits.size())
+		{
+			grow_slots(id / 64 + 1);
+			growths++;
+		}
+		dense[id] = (unsigned int)entities.size();
+		entities.push_back(e);
+		if (entities.capacity() != capacity)
+			growths++;
+		bits[id / 64] |= uint64_t(1) << (id % 64);
+		set_signature_bit(e);
+		return instance;
+	}
+
+	template<typename... Args>
+	Component& emplace(Entity e, Args &&... args) {
+		return insert(e, Component(std::forward<Args>(args)...));
+	};
+	template<typename... Args>
+	Component& emplace_with_duplicates(Entity e, Args &&... args) {
+		return insert(e, Component(std::forward<Args>(args)...), false);
+	};
+
+	Component& get(Entity e) {
+		assert(has(e) && "Entity not contained in ECS registry");
+		return instance;
+	}
+
+	// A set bit always belongs to the live entity of its slot, since destroying an entity removes its components first,
+	// so checking the generation is enough to reject stale handles
+	bool has(Entity e) const {
+		unsigned int id = e.index();
+		return id / 64 < bits.size() && (bits[id / 64] >> (id % 64) & 1) && Entity::valid(e);
+	}
+
+	void remove(Entity e)
+	{
+		if (has(e))
+		{
+			unsigned int id = e.index();
+			bits[id / 64] &= ~(uint64_t(1) << (id % 64));
+			// Swap the last tagged entity into the hole
+			unsigned int current = dense[id];
+			entities[current] = entities.back();
+			dense[entities[current].index()] = current;
+			entities.pop_back();
+			clear_signature_bit(e);
+		}
+	}
+
+	void clear()
+	{
+		for (Entity e : entities)
+		{
+			bits[e.index() / 64] &= ~(uint64_t(1) << (e.index() % 64));
+			clear_signature_bit(e);
+		}
 		entities.clear();
 	}
 
-	// Report the number of components of type 'Component'
 	size_t size()
 	{
-		return components.size();
+		return entities.size();
 	}
 
-	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// Make room for n tags in total, including the bits of the entity slots created next
+	void reserve(size_t n)
+	{
+		entities.reserve(n);
+		if (n > entities.size())
+		{
+			size_t words = (Entity::slot_count() + (n - entities.size())) / 64 + 1;
+			if (words > bits.size())
+				grow_slots(words);
+		}
+	}
+
+	// Sort the entity list by the comparisonFunction, see std::sort
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
-		// First sort the entity list as desired
 		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+			dense[entities[i].index()] = i;
+	}
+};
+
+template <typename Component, typename Allocator>
+class ComponentContainer<Component, true, Allocator> : public TagContainer<Component>
+{
+};
+
+// Records structural changes (destroy, add, remove) so they can be applied together at a sync point
+// instead of invalidating the containers a system is iterating over.
+// A buffer is not thread safe, every worker thread should record into its own buffer.
+class CommandBuffer
+{
+public:
+	// Commands are applied in this order, removals first and destruction last
+	enum class Op { REMOVE, ADD, DESTROY };
+	struct Command
+	{
+		Op op;
+		unsigned int container; // ContainerBase::id, 0 for DESTROY
+		Entity entity;
+		std::function<void()> insert; // only for ADD
+	};
+
+private:
+	std::vector<Command> commands;
+	// The handle scheduled for destruction per entity slot, 0 when there is none
+	std::vector<unsigned int> pending_destroy;
+
+	void mark_destroying(Entity e)
+	{
+		if (e.index() >= pending_destroy.size())
+			pending_destroy.resize(e.index() + 1, 0);
+		pending_destroy[e.index()] = e;
+	}
+
+public:
+	void destroy(Entity e)
+	{
+		commands.push_back({ Op::DESTROY, 0, e, nullptr });
+		mark_destroying(e);
+	}
+
+	template <typename Component>
+	void add(ComponentContainer<Component>& container, Entity e, Component c)
+	{
+		ComponentContainer<Component>* target = &container;
+		commands.push_back({ Op::ADD, container.id, e, [target, e, c]() {
+			if (!target->has(e))
+				target->insert(e, c);
+		} });
+	}
+
+	template <typename Component>
+	void remove(ComponentContainer<Component>& container, Entity e)
+	{
+		commands.push_back({ Op::REMOVE, container.id, e, nullptr });
+	}
+
+	// Check if e is already scheduled for destruction, so systems can skip it for the rest of the frame
+	bool destroying(Entity e) const
+	{
+		return (unsigned int)e != 0 && e.index() < pending_destroy.size() && pending_destroy[e.index()] == (unsigned int)e;
+	}
+
+	// Move all commands of another buffer (e.g. of a worker thread) to the end of this one
+	void merge(CommandBuffer& other)
+	{
+		for (const Command& command : other.commands)
+			if (command.op == Op::DESTROY)
+				mark_destroying(command.entity);
+		commands.insert(commands.end(), std::make_move_iterator(other.commands.begin()), std::make_move_iterator(other.commands.end()));
+		other.clear();
+	}
+
+	// Group the commands by operation and container so each container is touched in one go,
+	// the recording order is kept within a group
+	std::vector<Command>& sorted()
+	{
+		std::stable_sort(commands.begin(), commands.end(), [](const Command& a, const Command& b) {
+			if (a.op != b.op)
+				return a.op < b.op;
+			return a.container < b.container;
+		});
+		return commands;
+	}
+
+	bool empty() const { return commands.empty(); }
+	size_t size() const { return commands.size(); }
+	void clear()
+	{
+		for (const Command& command : commands)
+			if (command.op == Op::DESTROY && command.entity.index() < pending_destroy.size())
+				pending_destroy[command.entity.index()] = 0;
+		commands.clear();
+	}
+};
+
+// Component types an entity must not have to be part of a View, e.g. registry.view<Motion>(exclude<HUD>)
+template <typename... Excluded>
+struct Exclude {};
+template <typename... Excluded>
+constexpr Exclude<Excluded...> exclude{};
+
+// A query over all entities that have every 'Include' component and none of the 'Excluded' ones.
+// Iteration is driven by the smallest included container, the other containers are only probed.
+// Note, removing components or entities while iterating can skip entities, record them and apply afterwards.
+template <typename ExcludeList, typename... Include>
+class View;
+
+template <typename... Excluded, typename... Include>
+class View<Exclude<Excluded...>, Include...>
+{
+	static_assert(sizeof...(Include) > 0, "A view needs at least one included component type");
+
+	std::tuple<ComponentContainer<Include>*...> included;
+	std::tuple<ComponentContainer<Excluded>*...> excluded;
+	std::vector<Entity>* lead; // entities of the container that drives the iteration
+#ifdef ECS_ARCHETYPE_STORAGE
+	ArchetypeStorage* archetypes = nullptr; // walk the matching archetypes unless a lead container is pinned
+	const std::vector<uint64_t>* signatures = nullptr;
+	uint64_t include_mask = 0, exclude_mask = 0;
+#endif
+
+	void consider_lead(std::vector<Entity>& entities)
+	{
+		if (lead == nullptr || entities.size() < lead->size())
+			lead = &entities;
+	}
+
+public:
+	View(ComponentContainer<Include>&... include, ComponentContainer<Excluded>&... exclude)
+		: included(&include...), excluded(&exclude...), lead(nullptr)
+	{
+		(void)std::initializer_list<int>{ (consider_lead(include.entities), 0)... };
+	}
+
+	// Drive the iteration from the container of 'Component' instead of the smallest one,
+	// e.g. to keep the insertion order of render requests
+	template <typename Component>
+	View use() const
+	{
+		View view = *this;
+		view.lead = &std::get<ComponentContainer<Component>*>(included)->entities;
+#ifdef ECS_ARCHETYPE_STORAGE
+		view.archetypes = nullptr;
+#endif
+		return view;
+	}
+
+#ifdef ECS_ARCHETYPE_STORAGE
+	// Let each() walk the archetype chunks, the masks hold the container ids of Include and Excluded
+	void group_by(ArchetypeStorage* storage, const std::vector<uint64_t>* entity_signatures, uint64_t include, uint64_t exclude)
+	{
+		archetypes = storage;
+		signatures = entity_signatures;
+		include_mask = include;
+		exclude_mask = exclude;
+	}
+#endif
+
+	// Check that e has all included and none of the excluded components
+	bool contains(Entity e)
+	{
+		bool result = true;
+		(void)std::initializer_list<int>{ (result = result && std::get<ComponentContainer<Include>*>(included)->has(e), 0)... };
+		(void)std::initializer_list<int>{ (result = result && !std::get<ComponentContainer<Excluded>*>(excluded)->has(e), 0)... };
+		return result;
+	}
+
+	template <typename Component>
+	decltype(auto) get(Entity e)
+	{
+		return std::get<ComponentContainer<Component>*>(included)->get(e);
+	}
+
+	// Calls fn(entity, include_component&...) for every matching entity
+	template <typename Fn>
+	void each(Fn fn)
+	{
+#ifdef ECS_ARCHETYPE_STORAGE
+		if (archetypes != nullptr)
+		{
+			// Every row matched when it was grouped, the signature check catches changes made since
+			archetypes->each_chunk(include_mask, exclude_mask, [&](const uint32_t* rows, uint32_t count) {
+				for (uint32_t r = 0; r < count; r++)
+				{
+					Entity e(rows[r]);
+					uint64_t signature = (*signatures)[e.index()];
+					if (Entity::valid(e) && (signature & include_mask) == include_mask && (signature & exclude_mask) == 0)
+						fn(e, std::get<ComponentContainer<Include>*>(included)->get(e)...);
+				}
+			});
+			return;
+		}
+#endif
+		for (size_t i = 0; i < lead->size(); i++)
+		{
+			Entity e = (*lead)[i];
+			if (contains(e))
+				fn(e, std::get<ComponentContainer<Include>*>(included)->get(e)...);
+		}
+	}
+
+	// Iterates the matching entities, for use in range-based for loops
+	class iterator
+	{
+		View* view;
+		size_t i;
+		void skip() { while (i < view->lead->size() && !view->contains((*view->lead)[i])) i++; }
+	public:
+		iterator(View* view, size_t i) : view(view), i(i) { skip(); }
+		Entity operator*() const { return (*view->lead)[i]; }
+		iterator& operator++() { i++; skip(); return *this; }
+		bool operator!=(const iterator& other) const { return i != other.i; }
+	};
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, lead->size()); }
+};
+
+// Position of type T in the type list Ts, resolved at compile time
+template <typename T, typename... Ts>
+struct TypeIndex;
+template <typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<unsigned int, 0> {};
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...> : std::integral_constant<unsigned int, 1 + TypeIndex<T, Ts...>::value> {};
+
+// A registry over a compile-time list of component types, e.g. Registry<Motion, Player, Deadly>.
+// Every type gets one ComponentContainer kept in a std::tuple, so container lookups are resolved at compile time
+// and operations over all containers are fold expressions instead of virtual calls.
+template <typename... Components>
+class Registry
+{
+	static_assert(sizeof...(Components) <= 64, "Component signatures only have 64 bits");
+
+	std::tuple<ComponentContainer<Components>...> containers;
+	// Component signature of every entity slot, bit i is set if the i-th container holds the entity
+	std::vector<uint64_t> signatures;
+#ifdef ECS_ARCHETYPE_STORAGE
+	ArchetypeStorage archetype_storage;
+#endif
+	uint32_t current_epoch = 1;
+
+	template <typename Component>
+	static void remove_from(Registry& registry, Entity e) { registry.template container<Component>().remove(e); }
+	// The remove function of every container, indexed by ContainerBase::id
+	using Remover = void (*)(Registry&, Entity);
+	static constexpr Remover removers[] = { &Registry::remove_from<Components>... };
+
+public:
+	Registry()
+	{
+		unsigned int id = 0;
+		((container<Components>().id = id++, container<Components>().signatures = &signatures), ...);
+#ifdef ECS_ARCHETYPE_STORAGE
+		((container<Components>().archetypes = &archetype_storage), ...);
+#endif
+	}
+
+	// The signature bits of the given component types, e.g. to declare what a system reads and writes
+	template <typename... Masked>
+	static constexpr uint64_t mask() { return (uint64_t(0) | ... | (uint64_t(1) << TypeIndex<Masked, Components...>::value)); }
+
+	// The container that stores components of type 'Component'
+	template <typename Component>
+	ComponentContainer<Component>& container() { return std::get<ComponentContainer<Component>>(containers); }
+
+	// The component of e, a Component& or the reference type of a container with its own storage
+	template <typename Component>
+	decltype(auto) get(Entity e) { return container<Component>().get(e); }
+
+	// Check if e has a component of type 'Component' with a single bit test
+	template <typename Component>
+	bool has(Entity e) {
+		constexpr unsigned int id = TypeIndex<Component, Components...>::value;
+		return Entity::valid(e) && e.index() < signatures.size() && (signatures[e.index()] >> id & 1);
+	}
+
+	// Make room for 'additional' more components of every type in 'Reserved' and as many new entities,
+	// e.g. before a wave spawns, so the spawns do not reallocate
+	template <typename... Reserved>
+	void reserve(size_t additional) {
+		Entity::reserve(additional);
+		(container<Reserved>().reserve(container<Reserved>().size() + additional), ...);
+	}
+
+	// Print the containers whose storage was reallocated since the last report and start counting anew,
+	// returns the number of reallocations
+	size_t report_growth() {
+		size_t total = (size_t(0) + ... + container<Components>().growths);
+		if (total > 0) {
+			printf("Component storage reallocations:\n");
+			((container<Components>().growths > 0 ? printf("%4d of type %s\n", (int)container<Components>().growths, typeid(Components).name()) : 0), ...);
+		}
+		((container<Components>().growths = 0), ...);
+		return total;
+	}
+
+	// Record changes to the containers of 'Tracked', see ContainerBase::modified_since
+	template <typename... Tracked>
+	void track_changes() {
+		(container<Tracked>().track_changes(), ...);
+	}
+
+	// Entities whose 'Component' was added, removed or patched in the current epoch
+	template <typename Component>
+	const std::vector<Entity>& modified() { return container<Component>().modified(); }
+
+	uint32_t epoch() const { return current_epoch; }
+
+	// Start a new change tracking epoch, call once per frame after all systems ran
+	void next_epoch() {
+		current_epoch++;
+		((container<Components>().epoch = current_epoch, container<Components>().modified_entities.clear()), ...);
+	}
+
+	// The entity and component of a type that exists once, e.g. the player, without scanning the container
+	template <typename Component>
+	Entity single_entity() {
+		assert(container<Component>().size() > 0 && "No entity has this component");
+		return container<Component>().entities.back();
+	}
+	template <typename Component>
+	Component& single() {
+		assert(container<Component>().size() > 0 && "No entity has this component");
+		return container<Component>().components.back();
+	}
+
+	// Query all entities that have every 'Include' component, e.g. registry.view<Motion, Deadly>(exclude<HUD>)
+	template <typename... Include, typename... Excluded>
+	View<Exclude<Excluded...>, Include...> view(Exclude<Excluded...> = {})
+	{
+		View<Exclude<Excluded...>, Include...> view(container<Include>()..., container<Excluded>()...);
+#ifdef ECS_ARCHETYPE_STORAGE
+		archetype_storage.update(signatures);
+		view.group_by(&archetype_storage, &signatures, mask<Include...>(), mask<Excluded...>());
+#endif
+		return view;
+	}
+
+	void clear_all_components() {
+		(container<Components>().clear(), ...);
+	}
+
+	void list_all_components() {
+		printf("Debug info on all registry entries:\n");
+		((container<Components>().size() > 0 ? printf("%4d components of type %s\n", (int)container<Components>().size(), typeid(Components).name()) : 0), ...);
+	}
+
+	void list_all_components_of(Entity e) {
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		uint64_t signature = e.index() < signatures.size() ? signatures[e.index()] : 0;
+		((signature >> container<Components>().id & 1 ? printf("type %s\n", typeid(Components).name()) : 0), ...);
+	}
+
+	// Removes every component of e and destroys the entity, its slot is recycled
+	// Only the containers set in the signature of e are visited
+	void remove_all_components_of(Entity e) {
+		if (Entity::valid(e) && e.index() < signatures.size()) {
+			uint64_t signature = signatures[e.index()];
+			for (unsigned int i = 0; signature != 0; i++, signature >>= 1)
+				if (signature & 1)
+					removers[i](*this, e);
+		}
+		Entity::destroy(e);
+	}
+
+	// Structural changes recorded on the main thread, applied by flush_commands()
+	CommandBuffer commands;
+
+	// Apply and empty a command buffer, call this at a sync point where no system iterates the containers
+	void flush(CommandBuffer& buffer) {
+		for (CommandBuffer::Command& command : buffer.sorted())
+		{
+			if (command.op == CommandBuffer::Op::REMOVE)
+				removers[command.container](*this, command.entity);
+			else if (command.op == CommandBuffer::Op::ADD) {
+				if (Entity::valid(command.entity))
+					command.insert();
+			}
+			else
+				remove_all_components_of(command.entity);
+		}
+		buffer.clear();
+	}
+
+	void flush_commands() {
+		flush(commands);
 	}
 };
@@ -1,3 +1,35 @@
 #include "tiny_ecs_registry.hpp"
 
-ECSRegistry registry;
\ No newline at end of file
+ECSRegistry registry;
+
+// Projectiles alive at once are bounded by the reload times, not by the wave, this covers a crowded screen
+const size_t PROJECTILE_HEADROOM = 256;
+// Boss birds keep spawning bird clubs until this many enemies are alive, see WorldSystem::step
+const size_t MAX_ENEMIES_WITH_BOSS = 200;
+
+void ECSRegistry::reserve_for_wave(const Wave& wave)
+{
+	size_t enemies = wave.num_king_clubs + wave.num_bird_clubs + wave.num_queen_hearts + wave.num_bird_boss + wave.num_jokers + wave.num_genie_boss;
+	size_t birds = wave.num_bird_clubs;
+	if (wave.num_bird_boss > 0 && enemies < MAX_ENEMIES_WITH_BOSS)
+	{
+		birds += MAX_ENEMIES_WITH_BOSS - enemies;
+		enemies = MAX_ENEMIES_WITH_BOSS;
+	}
+	// Every joker clones itself once, see AISystem::cloneJoker
+	enemies += wave.num_jokers;
+
+	// Every enemy, projectile and coin has a mesh, a motion and a render request, and most enemies drop a coin
+	reserve<Mesh*, Motion, RenderRequest, CollisionFilter, Collider>(2 * enemies + PROJECTILE_HEADROOM);
+	reserve<Deadly>(enemies);
+	reserve<Eatable>(enemies);
+	reserve<Melee>(wave.num_king_clubs + 2 * wave.num_jokers);
+	reserve<Joker>(2 * wave.num_jokers);
+	reserve<Boid>(birds);
+	reserve<Healer>(wave.num_queen_hearts);
+	reserve<OtherDeadly>(wave.num_bird_boss);
+	reserve<Genie>(wave.num_genie_boss);
+	reserve<KillsEnemy>(PROJECTILE_HEADROOM);
+	reserve<HealsEnemy>(wave.num_queen_hearts * 4);
+	reserve<Bolt>(wave.num_genie_boss * 8);
+}
@@ -4,115 +4,89 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 
-class ECSRegistry
-{
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface*> registry_list;
+// All component types this game has, each one gets a container in the registry
+using GameRegistry = Registry<
+	DeathTimer,
+	Motion,
+	Player,
+	Mesh*,
+	OtherDeadly,
+	RenderRequest,
+	ScreenState,
+	Eatable,
+	Melee,
+	KillsEnemy,
+	HealsEnemy,
+	Healer,
+	KillsEnemyLerpyDerp,
+	Deadly,
+	Boid,
+	DebugComponent,
+	HomeAndTut,
+	Wave,
+	Door,
+	BuffNerf,
+	vec3,
+	HUD,
+	Coin,
+	Solid,
+	Shop,
+	LightUp,
+	HealthBar,
+	Floor,
+	FloorRenderRequest,
+	BlackRectangle,
+	Joker,
+	Tutorial,
+	Genie,
+	Bolt,
+	CollisionFilter,
+	Collider
+>;
 
+class ECSRegistry : public GameRegistry
+{
 public:
-	// Manually created list of all components this game has
-	// TODO: A1 add a LightUp component
-	ComponentContainer<DeathTimer> deathTimers;
-	ComponentContainer<Motion> motions;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Player> players;
-	ComponentContainer<Mesh*> meshPtrs;
-	ComponentContainer<OtherDeadly> otherDeadlys;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<Eatable> eatables;
-	ComponentContainer<Melee> melees;
-	ComponentContainer<KillsEnemy> killsEnemys;
-	ComponentContainer<HealsEnemy> healsEnemies;
-	ComponentContainer<Healer> healers;
-	ComponentContainer<KillsEnemyLerpyDerp> killsEnemyLerpyDerps;
-	ComponentContainer<Deadly> deadlys;
-	ComponentContainer<Boid> boids;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<HomeAndTut> homeAndTuts;
-	ComponentContainer<Wave> waves;
-	ComponentContainer<Door> doors;
-	ComponentContainer<BuffNerf> buffNerfs;
-	ComponentContainer<vec3> colors;
-	ComponentContainer<HUD> hud;
-	ComponentContainer<Coin> coins;
-	ComponentContainer<Solid> solids;
-	ComponentContainer<Shop> shopItems;
-	ComponentContainer<LightUp> lightUp;
-	ComponentContainer<HealthBar> healthBar; 
-	ComponentContainer<Floor> floors;
-	ComponentContainer<FloorRenderRequest> floorRenderRequests;
-	ComponentContainer<BlackRectangle> blackRectangles; 
-	ComponentContainer<Joker> jokers; 
-	ComponentContainer<Tutorial> tutorials;
-	ComponentContainer<Genie> genies; 
-	ComponentContainer<Bolt> bolts; // psst, if you're adding here, make sure to also add it below in the same place !!!
-
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
-	ECSRegistry()
-	{
-		// TODO: A1 add a LightUp component
-		registry_list.push_back(&deathTimers);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&players);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&otherDeadlys);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&eatables);
-		registry_list.push_back(&melees);
-		registry_list.push_back(&killsEnemys);
-		registry_list.push_back(&healsEnemies);
-		registry_list.push_back(&healers);
-		registry_list.push_back(&killsEnemyLerpyDerps);
-		registry_list.push_back(&deadlys);
-		registry_list.push_back(&boids);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&homeAndTuts);
-		registry_list.push_back(&waves);
-		registry_list.push_back(&doors);
-		registry_list.push_back(&buffNerfs);
-		registry_list.push_back(&colors);
-		registry_list.push_back(&hud);
-		registry_list.push_back(&coins);
-		registry_list.push_back(&solids); 
-		registry_list.push_back(&shopItems);
-		registry_list.push_back(&lightUp);
-		registry_list.push_back(&healthBar);
-		registry_list.push_back(&floors);
-		registry_list.push_back(&floorRenderRequests);
-		registry_list.push_back(&blackRectangles);
-		registry_list.push_back(&jokers);
-		registry_list.push_back(&tutorials);
-		registry_list.push_back(&genies);
-		registry_list.push_back(&bolts);
-	}
-
-	void clear_all_components() {
-		for (ContainerInterface* reg : registry_list)
-			reg->clear();
-	}
-
-	void list_all_components() {
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface* reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
-
-	void list_all_components_of(Entity e) {
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface* reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
-	}
+	// Named access to the containers, e.g. registry.motions is container<Motion>()
+	ComponentContainer<DeathTimer>& deathTimers = container<DeathTimer>();
+	ComponentContainer<Motion>& motions = container<Motion>();
+	ComponentContainer<Player>& players = container<Player>();
+	ComponentContainer<Mesh*>& meshPtrs = container<Mesh*>();
+	ComponentContainer<OtherDeadly>& otherDeadlys = container<OtherDeadly>();
+	ComponentContainer<RenderRequest>& renderRequests = container<RenderRequest>();
+	ComponentContainer<ScreenState>& screenStates = container<ScreenState>();
+	ComponentContainer<Eatable>& eatables = container<Eatable>();
+	ComponentContainer<Melee>& melees = container<Melee>();
+	ComponentContainer<KillsEnemy>& killsEnemys = container<KillsEnemy>();
+	ComponentContainer<HealsEnemy>& healsEnemies = container<HealsEnemy>();
+	ComponentContainer<Healer>& healers = container<Healer>();
+	ComponentContainer<KillsEnemyLerpyDerp>& killsEnemyLerpyDerps = container<KillsEnemyLerpyDerp>();
+	ComponentContainer<Deadly>& deadlys = container<Deadly>();
+	ComponentContainer<Boid>& boids = container<Boid>();
+	ComponentContainer<DebugComponent>& debugComponents = container<DebugComponent>();
+	ComponentContainer<HomeAndTut>& homeAndTuts = container<HomeAndTut>();
+	ComponentContainer<Wave>& waves = container<Wave>();
+	ComponentContainer<Door>& doors = container<Door>();
+	ComponentContainer<BuffNerf>& buffNerfs = container<BuffNerf>();
+	ComponentContainer<vec3>& colors = container<vec3>();
+	ComponentContainer<HUD>& hud = container<HUD>();
+	ComponentContainer<Coin>& coins = container<Coin>();
+	ComponentContainer<Solid>& solids = container<Solid>();
+	ComponentContainer<Shop>& shopItems = container<Shop>();
+	ComponentContainer<LightUp>& lightUp = container<LightUp>();
+	ComponentContainer<HealthBar>& healthBar = container<HealthBar>();
+	ComponentContainer<Floor>& floors = container<Floor>();
+	ComponentContainer<FloorRenderRequest>& floorRenderRequests = container<FloorRenderRequest>();
+	ComponentContainer<BlackRectangle>& blackRectangles = container<BlackRectangle>();
+	ComponentContainer<Joker>& jokers = container<Joker>();
+	ComponentContainer<Tutorial>& tutorials = container<Tutorial>();
+	ComponentContainer<Genie>& genies = container<Genie>();
+	ComponentContainer<Bolt>& bolts = container<Bolt>();
+	ComponentContainer<CollisionFilter>& collisionFilters = container<CollisionFilter>();
+	ComponentContainer<Collider>& colliders = container<Collider>();
 
-	void remove_all_components_of(Entity e) {
-		for (ContainerInterface* reg : registry_list)
-			reg->remove(e);
-	}
+	// Pre-size the containers for the enemies, projectiles and coins of a wave, call once its counts are set
+	void reserve_for_wave(const Wave& wave);
 };
 
 extern ECSRegistry registry;
\ No newline at end of file
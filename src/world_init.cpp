@@ -3,13 +3,20 @@
 #include <iostream>
 #include "components.hpp"
 
+// Collide with the shape of what the entity draws, call once its render request is set
+static void add_collider(RenderSystem* renderer, Entity entity)
+{
+	registry.colliders.insert(entity, { &renderer->getCollisionShape(registry.renderRequests.get(entity)) });
+}
+
 Entity createProtagonist(RenderSystem* renderer, vec2 pos, Player* copy_player) {
 	auto entity = Entity();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PLAYER_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -38,6 +45,7 @@ Entity createProtagonist(RenderSystem* renderer, vec2 pos, Player* copy_player)
 		{ TEXTURE_ASSET_ID::PROTAGONIST_FORWARD, 
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE });
+	add_collider(renderer, entity);
 
 	return entity;
 
@@ -49,7 +57,8 @@ Entity createWallBlock(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, SOLID_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -59,10 +68,10 @@ Entity createWallBlock(RenderSystem* renderer, vec2 pos) {
 
 	int grid_x = static_cast<int>(pos.x / 12);
 	int grid_y = static_cast<int>(pos.y / 12);
-	cells[grid_y*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y-1)*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y-1)*GRID_WIDTH + grid_x-1].exist = true;
-	cells[grid_y*GRID_WIDTH + grid_x-1].exist = true;
+	level.mark_wall_cell(grid_y, grid_x);
+	level.mark_wall_cell(grid_y-1, grid_x);
+	level.mark_wall_cell(grid_y-1, grid_x-1);
+	level.mark_wall_cell(grid_y, grid_x-1);
 	// Set the central grid block to 1
 	grid[grid_y][grid_x] = 1;
 	grid[grid_y][grid_x-1] = 1;
@@ -80,7 +89,7 @@ Entity createWallBlock(RenderSystem* renderer, vec2 pos) {
 			int new_x = grid_x + dx;
 			
 			// Ensure indices are within grid boundaries
-			if (new_y >= 0 && new_y < GRID_HEIGHT && new_x >= 0 && new_x < GRID_WIDTH && grid[new_y][new_x] == 0) {
+			if (grid.inside(new_y, new_x) && grid[new_y][new_x] == 0) {
 				grid[new_y][new_x] = 2;
 			}
 		}
@@ -103,7 +112,8 @@ Entity createSlotMachine(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, SOLID_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -120,14 +130,14 @@ Entity createSlotMachine(RenderSystem* renderer, vec2 pos) {
 	grid[grid_y+1][grid_x-1] = 1;
 	grid[grid_y-2][grid_x] = 1;
 	grid[grid_y-2][grid_x-1] = 1;
-	cells[grid_y*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y-1)*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y-1)*GRID_WIDTH + grid_x-1].exist = true;
-	cells[grid_y*GRID_WIDTH + grid_x-1].exist = true;
-	cells[(grid_y+1)*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y+1)*GRID_WIDTH + grid_x-1].exist = true;
-	cells[(grid_y-2)*GRID_WIDTH + grid_x].exist = true;
-	cells[(grid_y-2)*GRID_WIDTH + grid_x-1].exist = true;
+	level.mark_wall_cell(grid_y, grid_x);
+	level.mark_wall_cell(grid_y-1, grid_x);
+	level.mark_wall_cell(grid_y-1, grid_x-1);
+	level.mark_wall_cell(grid_y, grid_x-1);
+	level.mark_wall_cell(grid_y+1, grid_x);
+	level.mark_wall_cell(grid_y+1, grid_x-1);
+	level.mark_wall_cell(grid_y-2, grid_x);
+	level.mark_wall_cell(grid_y-2, grid_x-1);
 	// Mark grid cells occupied by slot machine
 	for (int dy = -5; dy <= 4; dy++) {
 		for (int dx = -3; dx <= 2; dx++) {
@@ -139,7 +149,7 @@ Entity createSlotMachine(RenderSystem* renderer, vec2 pos) {
 			int new_x = grid_x + dx;
 			
 			// Ensure indices are within grid boundaries
-			if (new_y >= 0 && new_y < GRID_HEIGHT && new_x >= 0 && new_x < GRID_WIDTH && grid[new_y][new_x] == 0) {
+			if (grid.inside(new_y, new_x) && grid[new_y][new_x] == 0) {
 				grid[new_y][new_x] = 2;
 			}
 		}
@@ -162,7 +172,8 @@ Entity createRouletteTable(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, SOLID_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -185,7 +196,7 @@ Entity createRouletteTable(RenderSystem* renderer, vec2 pos) {
 			int new_x = grid_x + dx;
 			
 			// Ensure indices are within grid boundaries
-			if (new_y >= 0 && new_y < GRID_HEIGHT && new_x >= 0 && new_x < GRID_WIDTH && grid[new_y][new_x] == 0) {
+			if (grid.inside(new_y, new_x) && grid[new_y][new_x] == 0) {
 				grid[new_y][new_x] = 2;
 			}
 		}
@@ -208,7 +219,8 @@ Entity createFloorBlock(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, FLOOR_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -230,7 +242,8 @@ Entity createDoor(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, DOOR_COLLISIONS);
 	motion.position = pos;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -269,7 +282,8 @@ Entity createQueenHearts(RenderSystem* renderer, vec2 position, int wave_num)
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
@@ -294,6 +308,7 @@ Entity createQueenHearts(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 	return entity;
 }
 
@@ -304,7 +319,8 @@ Entity createKingClubs(RenderSystem* renderer, vec2 position, int wave_num)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -330,6 +346,7 @@ Entity createKingClubs(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -341,7 +358,8 @@ Entity createBirdClubs(RenderSystem* renderer, vec2 position, int wave_num)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -367,6 +385,7 @@ Entity createBirdClubs(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -378,7 +397,8 @@ Entity createBossBirdClubs(RenderSystem* renderer, vec2 position, int wave_num)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -405,6 +425,7 @@ Entity createBossBirdClubs(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -416,7 +437,8 @@ Entity createJoker(RenderSystem* renderer, vec2 position, int wave_num)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -450,6 +472,7 @@ Entity createJoker(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -461,7 +484,8 @@ Entity createGenie(RenderSystem* renderer, vec2 position, int wave_num)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, ENEMY_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -492,17 +516,19 @@ Entity createGenie(RenderSystem* renderer, vec2 position, int wave_num)
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
 
-Entity createHeartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity, Entity* target_entity, int wave_num) {
+Entity createHeartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity, Entity target_entity, int wave_num) {
 	auto entity = Entity();
 
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, HEART_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = velocity;
 	motion.position = position;
@@ -528,6 +554,7 @@ Entity createHeartProjectile(RenderSystem* renderer, vec2 position, vec2 velocit
 			GEOMETRY_BUFFER_ID::SPRITE
 		}
 	);
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -538,7 +565,8 @@ Entity createBoltProjectile(RenderSystem* renderer, vec2 position, vec2 targetPo
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, BOLT_COLLISIONS);
 	motion.angle = atan2(targetPosition.y - position.y, targetPosition.x - position.x) - M_PI / 2;
 	vec2 direction = normalize(targetPosition - position);
 
@@ -558,6 +586,7 @@ Entity createBoltProjectile(RenderSystem* renderer, vec2 position, vec2 targetPo
 			GEOMETRY_BUFFER_ID::SPRITE
 		}
 	);
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -569,7 +598,8 @@ Entity createRouletteBall(RenderSystem* renderer, vec2 position, vec2 velocity,
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::ROULETTE_BALL_GEOB);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PLAYER_PROJECTILE_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = velocity;
 	motion.position = position;
@@ -588,6 +618,7 @@ Entity createRouletteBall(RenderSystem* renderer, vec2 position, vec2 velocity,
 			EFFECT_ASSET_ID::ROULETTE_BALL_EFFA,
 			GEOMETRY_BUFFER_ID::ROULETTE_BALL_GEOB 
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -599,7 +630,8 @@ Entity createCardProjectile(RenderSystem* renderer, vec2 position, vec2 velocity
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PLAYER_PROJECTILE_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = velocity;
 	motion.position = position;
@@ -618,6 +650,7 @@ Entity createCardProjectile(RenderSystem* renderer, vec2 position, vec2 velocity
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -629,7 +662,8 @@ Entity createDartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PLAYER_PROJECTILE_COLLISIONS);
 	motion.angle = angle + 0.5 * M_PI;
 	motion.velocity = velocity;
 	motion.position = position;
@@ -647,6 +681,7 @@ Entity createDartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -658,7 +693,8 @@ Entity createDiamondProjectile(RenderSystem* renderer, vec2 position, vec2 veloc
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::DIAMOND);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PLAYER_PROJECTILE_COLLISIONS);
 	motion.angle = angle + 0.5 * M_PI;
 	motion.velocity = velocity;
 	motion.position = position;
@@ -676,6 +712,7 @@ Entity createDiamondProjectile(RenderSystem* renderer, vec2 position, vec2 veloc
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::DIAMOND
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -686,7 +723,8 @@ Entity createCoin(RenderSystem* renderer, vec2 position) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, PICKUP_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -702,6 +740,7 @@ Entity createCoin(RenderSystem* renderer, vec2 position) {
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -712,7 +751,8 @@ Entity createHUDCoin(RenderSystem* renderer, vec2 position) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -738,7 +778,8 @@ Entity createHealthBar(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = pos;
@@ -764,7 +805,8 @@ Entity createHealthBarFrame(RenderSystem* renderer, vec2 pos) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = pos;
@@ -790,7 +832,8 @@ Entity createHUD(RenderSystem* renderer, vec2 position, vec2 size) {
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::HUD);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.position = position;
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
@@ -818,7 +861,8 @@ Entity createLerpProjectile(RenderSystem* renderer, vec2 position,vec2 startpos,
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, LERP_PROJECTILE_COLLISIONS);
 	motion.angle = angle;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -837,6 +881,7 @@ Entity createLerpProjectile(RenderSystem* renderer, vec2 position,vec2 startpos,
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE
 		});
+	add_collider(renderer, entity);
 
 	return entity;
 }
@@ -854,7 +899,8 @@ Entity createLine(vec2 position, vec2 scale)
 		});
 
 	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -877,7 +923,8 @@ Entity createBlackRectangle(vec2 position, vec2 scale)
 		});
 
 	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, BLACK_RECTANGLE_COLLISIONS);
 	registry.blackRectangles.emplace(entity);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
@@ -894,7 +941,8 @@ Entity createArrowLeft(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -923,7 +971,8 @@ Entity createArrowRight(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -952,7 +1001,8 @@ Entity createArrowUp(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -981,7 +1031,8 @@ Entity createArrowDown(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -1010,7 +1061,8 @@ Entity createDashLeft(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -1039,7 +1091,8 @@ Entity createDashRight(RenderSystem* renderer, vec2 position, vec2 scale)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0.f, 0.f };
 	motion.position = position;
@@ -1068,7 +1121,8 @@ Entity createHomeScreen(RenderSystem* renderer, vec2 position)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -1095,7 +1149,8 @@ Entity createDoorScreen(RenderSystem* renderer, vec2 position, int door_type)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -1149,7 +1204,8 @@ Entity createShopScreen(RenderSystem* renderer, vec2 position)
 	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
 	registry.meshPtrs.emplace(entity, &mesh);
 
-	auto& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
@@ -1183,7 +1239,8 @@ Entity createUpgradeLine(vec2 position, vec2 scale)
 		});
 
 	// Create motion
-	Motion& motion = registry.motions.emplace(entity);
+	MotionRef motion = registry.motions.emplace(entity);
+	registry.collisionFilters.insert(entity, UI_COLLISIONS);
 	motion.angle = 0.f;
 	motion.velocity = { 0, 0 };
 	motion.position = position;
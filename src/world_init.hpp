@@ -41,6 +41,20 @@ const float ROULETTE_TABLE_BB_WIDTH = 120.f;
 //const float ROULETTE_TABLE_BB_HEIGHT = 60.f * 1.f;
 const float ROULETTE_TABLE_BB_HEIGHT = 72.f;
 
+// Collision filters set by the factories, every mask only holds the layers WorldSystem::handle_collisions acts on
+const CollisionFilter PLAYER_COLLISIONS = { LAYER_PLAYER, LAYER_ENEMY | LAYER_ENEMY_PROJECTILE | LAYER_PICKUP | LAYER_STATIC };
+const CollisionFilter ENEMY_COLLISIONS = { LAYER_ENEMY, LAYER_PLAYER | LAYER_PLAYER_PROJECTILE | LAYER_ENEMY_PROJECTILE | LAYER_UI };
+const CollisionFilter PLAYER_PROJECTILE_COLLISIONS = { LAYER_PLAYER_PROJECTILE, LAYER_ENEMY | LAYER_STATIC };
+const CollisionFilter LERP_PROJECTILE_COLLISIONS = { LAYER_PLAYER_PROJECTILE, LAYER_ENEMY };
+const CollisionFilter BOLT_COLLISIONS = { LAYER_ENEMY_PROJECTILE, LAYER_PLAYER };
+const CollisionFilter HEART_COLLISIONS = { LAYER_ENEMY_PROJECTILE, LAYER_ENEMY };
+const CollisionFilter PICKUP_COLLISIONS = { LAYER_PICKUP, LAYER_PLAYER };
+const CollisionFilter SOLID_COLLISIONS = { LAYER_STATIC, LAYER_PLAYER | LAYER_PLAYER_PROJECTILE };
+const CollisionFilter DOOR_COLLISIONS = { LAYER_STATIC, LAYER_PLAYER };
+const CollisionFilter FLOOR_COLLISIONS = { LAYER_STATIC, 0 };
+const CollisionFilter BLACK_RECTANGLE_COLLISIONS = { LAYER_UI, LAYER_ENEMY };
+const CollisionFilter UI_COLLISIONS = { LAYER_UI, 0 };
+
 
 // the new player
 Entity createProtagonist(RenderSystem* renderer, vec2 pos, Player* copy_player);
@@ -52,7 +66,7 @@ Entity createBossBirdClubs(RenderSystem* renderer, vec2 position, int wave_num);
 Entity createJoker(RenderSystem* renderer, vec2 position, int wave_num);
 Entity createGenie(RenderSystem* renderer, vec2 position, int wave_num);
 
-Entity createHeartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity, Entity* target_entity, int wave_num);
+Entity createHeartProjectile(RenderSystem* renderer, vec2 position, vec2 velocity, Entity target_entity, int wave_num);
 Entity createBoltProjectile(RenderSystem* renderer, vec2 position, vec2 targetPosition, int wave_num);
 
 Entity createRouletteBall(RenderSystem* renderer, vec2 position, vec2 velocity, float dmg, int bounce);
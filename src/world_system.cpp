@@ -14,6 +14,7 @@
 #include <cmath> 
 #include "components.hpp"
 #include "grid.hpp"
+#include "tile_sweep.hpp"
 
 using json = nlohmann::json;
 
@@ -193,7 +194,7 @@ void WorldSystem::init(RenderSystem* renderer_arg, std::string* state) {
 // Update our game world
 bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	
-	Motion& p_motion = registry.motions.get(player_protagonist);
+	MotionRef p_motion = registry.motions.get(player_protagonist);
 	Player& p_you = registry.players.get(player_protagonist);
 	Wave& wave = registry.waves.get(global_wave);
 
@@ -340,10 +341,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 	float bottom_bound = 912;
 
-	for (int i = (int)motions_registry.components.size() - 1; i >= 0; --i) {
-		Motion& motion = motions_registry.components[i];
-		if (motion.position.x < left_bound-36 || motion.position.x > right_bound +36||
-			motion.position.y < top_bound-36 || motion.position.y > bottom_bound+36) {
+	for (int i = (int)motions_registry.size() - 1; i >= 0; --i) {
+		vec2 position = motions_registry.position[i];
+		if (position.x < left_bound-36 || position.x > right_bound +36||
+			position.y < top_bound-36 || position.y > bottom_bound+36) {
 			if (!registry.players.has(motions_registry.entities[i])) // don't remove the player
 				registry.remove_all_components_of(motions_registry.entities[i]);
 		}
@@ -352,7 +353,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	// Update health bar
 	if (!registry.healthBar.entities.empty()) {
 		Entity health_bar = registry.healthBar.entities[0];
-		Motion& health_motion = registry.motions.get(health_bar);
+		MotionRef health_motion = registry.motions.get(health_bar);
 
 		float full_width = 180.f; // from createHealthBar() in world_init.cpp 
 		float health_ratio = std::max(0.0f, std::min(p_you.health / p_you.max_health, 1.0f)); // ensures 0 <= ratio <=1
@@ -398,17 +399,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 					int grid_x = static_cast<int>(spawnX / 12);
 					int grid_y = static_cast<int>(spawnY / 12);
-					for (int dy = -3; dy <= 3 && valid_spawn; ++dy) {
-						for (int dx = -2; dx <= 2 && valid_spawn; ++dx) {
-
-							int check_x = grid_x + dx;
-							int check_y = grid_y + dy;
-							if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-								if (grid[check_y][check_x] == 1) {
-									valid_spawn = false;
-								}
-							}
-						}
+					if (grid.any_in_rect(grid_y - 3, grid_x - 2, grid_y + 3, grid_x + 2, CELLS_WALL)) {
+						valid_spawn = false;
 					}
 				} while (!valid_spawn);
 				createKingClubs(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -441,17 +433,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
                 int grid_x = static_cast<int>(spawnX / 12);
                 int grid_y = static_cast<int>(spawnY / 12);
-                for (int dy = -12; dy <= 12 && valid_spawn; ++dy) {
-                    for (int dx = -8; dx <= 8 && valid_spawn; ++dx) {
-
-                        int check_x = grid_x + dx;
-                        int check_y = grid_y + dy;
-                        if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-                            if (grid[check_y][check_x] == 1) {
-                                valid_spawn = false;
-                            }
-                        }
-                    }
+                if (grid.any_in_rect(grid_y - 12, grid_x - 8, grid_y + 12, grid_x + 8, CELLS_WALL)) {
+                    valid_spawn = false;
                 }
             } while (!valid_spawn);
 				createQueenHearts(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -483,17 +466,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
                 int grid_x = static_cast<int>(spawnX / 12);
                 int grid_y = static_cast<int>(spawnY / 12);
-                for (int dy = -3; dy <= 3 && valid_spawn; ++dy) {
-                    for (int dx = -2; dx <= 2 && valid_spawn; ++dx) {
-
-                        int check_x = grid_x + dx;
-                        int check_y = grid_y + dy;
-                        if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-                            if (grid[check_y][check_x] == 1) {
-                                valid_spawn = false;
-                            }
-                        }
-                    }
+                if (grid.any_in_rect(grid_y - 3, grid_x - 2, grid_y + 3, grid_x + 2, CELLS_WALL)) {
+                    valid_spawn = false;
                 }
             } while (!valid_spawn);
 				createBirdClubs(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -526,17 +500,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
                 int grid_x = static_cast<int>(spawnX / 12);
                 int grid_y = static_cast<int>(spawnY / 12);
-                for (int dy = -3; dy <= 3 && valid_spawn; ++dy) {
-                    for (int dx = -2; dx <= 2 && valid_spawn; ++dx) {
-
-                        int check_x = grid_x + dx;
-                        int check_y = grid_y + dy;
-                        if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-                            if (grid[check_y][check_x] == 1) {
-                                valid_spawn = false;
-                            }
-                        }
-                    }
+                if (grid.any_in_rect(grid_y - 3, grid_x - 2, grid_y + 3, grid_x + 2, CELLS_WALL)) {
+                    valid_spawn = false;
                 }
             } while (!valid_spawn);
 				createBossBirdClubs(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -569,17 +534,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 					int grid_x = static_cast<int>(spawnX / 12);
 					int grid_y = static_cast<int>(spawnY / 12);
-					for (int dy = -3; dy <= 3 && valid_spawn; ++dy) {
-						for (int dx = -2; dx <= 2 && valid_spawn; ++dx) {
-
-							int check_x = grid_x + dx;
-							int check_y = grid_y + dy;
-							if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-								if (grid[check_y][check_x] == 1) {
-									valid_spawn = false;
-								}
-							}
-						}
+					if (grid.any_in_rect(grid_y - 3, grid_x - 2, grid_y + 3, grid_x + 2, CELLS_WALL)) {
+						valid_spawn = false;
 					}
 				} while (!valid_spawn);
 				createJoker(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -611,17 +567,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 					int grid_x = static_cast<int>(spawnX / 12);
 					int grid_y = static_cast<int>(spawnY / 12);
-					for (int dy = -3; dy <= 3 && valid_spawn; ++dy) {
-						for (int dx = -2; dx <= 2 && valid_spawn; ++dx) {
-
-							int check_x = grid_x + dx;
-							int check_y = grid_y + dy;
-							if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-								if (grid[check_y][check_x] == 1) {
-									valid_spawn = false;
-								}
-							}
-						}
+					if (grid.any_in_rect(grid_y - 3, grid_x - 2, grid_y + 3, grid_x + 2, CELLS_WALL)) {
+						valid_spawn = false;
 					}
 				} while (!valid_spawn);
 				createGenie(renderer, vec2(spawnX, spawnY), wave.wave_num);
@@ -767,7 +714,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	float angle = std::atan2(dy, dx);
 
 	auto& p_render = registry.renderRequests.get(player_protagonist);
-	auto& motion = registry.motions.get(player_protagonist);
+	MotionRef motion = registry.motions.get(player_protagonist);
 	
 	if (angle > -M_PI / 4 && angle <= M_PI / 4) {
 		// Right
@@ -798,6 +745,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			EFFECT_ASSET_ID::TEXTURED,
 			GEOMETRY_BUFFER_ID::SPRITE };
 	}
+	// The hit box follows the animation frame
+	if (registry.colliders.has(player_protagonist)) {
+		registry.colliders.get(player_protagonist).shape = &renderer->getCollisionShape(p_render);
+	}
 
 	if (wave.state == "game on") {
 		// spawn roulette balls
@@ -858,15 +809,12 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 			}
 		}
 		for (Entity entity : registry.bolts.entities) {
-			Motion& motion = registry.motions.get(entity);
-
-			vec2 new_position = motion.position + motion.velocity * elapsed_time / 200.f;
+			MotionRef motion = registry.motions.get(entity);
+			vec2 new_position = motion.position + motion.velocity * (elapsed_time / 200.f);
 
-			int grid_x = static_cast<int>(new_position.x) / 12;
-			int grid_y = static_cast<int>(new_position.y) / 12;
-
-			if (grid[grid_y][grid_x] == 1) {
-				registry.remove_all_components_of(entity);
+			// Bolts break on the first wall they reach
+			if (sweep_tiles(motion.position, abs(motion.scale) / 2.f, new_position - motion.position).hit) {
+				registry.commands.destroy(entity);
 			}
 			else {
 				motion.position = new_position;
@@ -876,9 +824,10 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 
 	if (!(wave.state == "game on")) {
 		for (Entity entity : registry.bolts.entities) {
-			registry.remove_all_components_of(entity);
+			registry.commands.destroy(entity);
 		}
 	}
+	registry.flush_commands();
 
 	// 	next_lerp_spawn -= elapsed_ms_since_last_update * current_speed;
 	// 	if (next_lerp_spawn < 0.f) {
@@ -887,7 +836,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
 	// }
 
 	for (Entity entity : registry.otherDeadlys.entities) {
-        Motion& motion = registry.motions.get(entity);
+        MotionRef motion = registry.motions.get(entity);
         
         vec2 position = {motion.position.x, motion.position.y};
         vec2 velocity = {0.f, 0.f};
@@ -925,7 +874,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update) {
     }
 
 	assert(registry.screenStates.components.size() <= 1);
-    ScreenState &screen = registry.screenStates.components[0];
+    ScreenState &screen = registry.single<ScreenState>();
 
 	for (Entity entity : registry.lightUp.entities) {
 		LightUp& lightUp = registry.lightUp.get(entity);
@@ -985,7 +934,8 @@ void WorldSystem::restart_game() {
 	// Reset the game speed
 	current_speed = 1.f;
 
-	memset(grid, 0, sizeof(grid));
+	level.resize(DEFAULT_LEVEL_WIDTH, DEFAULT_LEVEL_HEIGHT);
+	level.carve(0, 0, DEFAULT_LEVEL_HEIGHT - 1, DEFAULT_LEVEL_WIDTH - 1);
 	// for (int i=1;i<39;i++){
 	// 	for (int j=1;j<79;j++){
 	// 		if (grid[i][j] == 4){
@@ -1024,18 +974,14 @@ void WorldSystem::restart_game() {
 	// random interior Wall
 	// createWallBlock(renderer, {84,108});
 	// Top and bottom Wall
-		for (int i = 0;i<GRID_WIDTH;i++){
-			for (int j =0 ;j<GRID_HEIGHT;j++){
-				cells[j*GRID_WIDTH + i].exist = false;
-			}
-		}
+	level.clear_wall_cells();
 	for (int i = 0; i < num_blocks * 2; i++) {
 		createWallBlock(renderer, {i * WALL_BLOCK_BB_WIDTH+12,12});
-		createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH,948});
+		createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH,level.height_px()-12});
 	}
 	// Right and left Wall
 	for (int i = 0; i < num_blocks; i++) {
-		createWallBlock(renderer, {1920-12,12 + i * WALL_BLOCK_BB_HEIGHT});
+		createWallBlock(renderer, {level.width_px()-12,12 + i * WALL_BLOCK_BB_HEIGHT});
 		createWallBlock(renderer, {12,12 + i * WALL_BLOCK_BB_HEIGHT});
 	}
 
@@ -1051,10 +997,33 @@ void WorldSystem::restart_game() {
 
 }
 
+// Sizes the level for a room of outerWidth x outerHeight wall blocks, at least the default level, and makes the room
+// floor. The cells around the room are left without chunks and read as walls.
+static void layout_room(int outerWidth, int outerHeight) {
+	level.resize(std::max(outerWidth * 2, DEFAULT_LEVEL_WIDTH), std::max(outerHeight * 2, DEFAULT_LEVEL_HEIGHT));
+	level.carve(0, 0, outerHeight * 2 - 1, outerWidth * 2 - 1);
+}
+
+// Covers the floor background of the level to the right of and below the room
+static void cover_outside_room(int outerWidth, int outerHeight) {
+	float room_width = outerWidth * WALL_BLOCK_BB_WIDTH;
+	float room_height = outerHeight * WALL_BLOCK_BB_HEIGHT;
+	// outside outer to the right
+	if (room_width < level.width_px()) {
+		createBlackRectangle({(level.width_px() + room_width) / 2, level.height_px() / 2}, {level.width_px() - room_width, level.height_px()});
+	}
+	// outside outer below
+	if (room_height < level.height_px()) {
+		createBlackRectangle({room_width / 2, (level.height_px() + room_height) / 2}, {room_width, level.height_px() - room_height});
+	}
+}
+
 void WorldSystem::next_wave() {
 	Player& your = registry.players.get(player_protagonist);
 	Wave& wave = registry.waves.get(global_wave);
-	Motion& player_motion = registry.motions.get(player_protagonist);
+	MotionRef player_motion = registry.motions.get(player_protagonist);
+	// The previous wave should have spawned without reallocating, see reserve_for_wave below
+	registry.report_growth();
 	wave.wave_num += 1;
 	// array of length 20, index by wave_num to get number of enemies per round
 	int num_of_enemies[] = {
@@ -1542,6 +1511,7 @@ void WorldSystem::next_wave() {
 		wave.num_genie_boss = num_genies;
 		wave.delay_for_all_entities = 1200;
 	}
+	registry.reserve_for_wave(wave);
 
 	// wave.state = "game on"
 	
@@ -1594,9 +1564,6 @@ void WorldSystem::next_wave() {
 		registry.remove_all_components_of(registry.doors.entities.back());
 
 
-	// set all grid to 0
-	memset(grid, 0, sizeof(grid));
-
 	// remove previous black rectangles
 	while (registry.blackRectangles.entities.size() > 0)
 		registry.remove_all_components_of(registry.blackRectangles.entities.back());
@@ -1617,12 +1584,6 @@ void WorldSystem::next_wave() {
 	player_motion.velocity *= 0.f;
 	your.push *= 0;
 
-	for (int i = 0;i<GRID_WIDTH;i++){
-		for (int j =0 ;j<GRID_HEIGHT;j++){
-			cells[j*GRID_WIDTH + i].exist = false;
-		}
-	}
-
 	// randomly pick room type
 	int max_tables_count = 1;
 	int max_slots_count = 1;
@@ -1645,6 +1606,7 @@ void WorldSystem::next_wave() {
 		max_slots_count = floor(outerWidth/11);
 
 		std::cout << "rectangle dimensions. outer w/h: " << outerWidth << '/' << outerHeight << std::endl;
+		layout_room(outerWidth, outerHeight);
 		// walls outer
 		for (int i = 0; i < outerWidth; i++) {
 			createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH, 12}); // outer top wall
@@ -1656,31 +1618,7 @@ void WorldSystem::next_wave() {
 		}
 
 		// cover floor background in non playable area
-		// outside outer to the right
-		if (outerWidth < 80) {
-			createBlackRectangle({1920 - ((80 - outerWidth)/2) * WALL_BLOCK_BB_WIDTH, 480}, {(80 - outerWidth) * WALL_BLOCK_BB_WIDTH, 960});
-		}
-		// outside outer below
-		if (outerHeight < 40) {
-			createBlackRectangle({WALL_BLOCK_BB_WIDTH * outerWidth/2, 960 - ((40 - outerHeight)/2) * WALL_BLOCK_BB_HEIGHT}, {WALL_BLOCK_BB_WIDTH * outerWidth, WALL_BLOCK_BB_HEIGHT * (40 - outerHeight)});
-		}
-
-		// make right bar outside of rectangle unspawnable
-		if (outerWidth < 80) {
-			for (int j = 0; j < 80; j++) {
-				for (int i = outerWidth * 2; i < 160; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
-		// make below rectangle unspawnable
-		if (outerHeight < 40) {
-			for (int j = outerHeight * 2; j < 80; j++) {
-				for (int i = 0; i < outerWidth * 2; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
+		cover_outside_room(outerWidth, outerHeight);
 
 		// move player to starting location
 		player_motion.position = vec2(WALL_BLOCK_BB_WIDTH * outerWidth / 2, 84);
@@ -1700,12 +1638,8 @@ void WorldSystem::next_wave() {
 		max_slots_count = floor(outerWidth/11);
 
 		std::cout << "donut dimensions. outer w/h, inner w/h: " << outerWidth << '/' << outerHeight << ':' << innerWidth << "/" << innerHeight << std::endl;
+		layout_room(outerWidth, outerHeight);
 		// walls outer
-		for (int i = 0;i<GRID_WIDTH;i++){
-			for (int j =0 ;j<GRID_HEIGHT;j++){
-				cells[j*GRID_WIDTH + i].exist = false;
-			}
-		}
 		for (int i = 0; i < outerWidth; i++) {
 			createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH, 12}); // outer top wall
 			createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH, 12 + WALL_BLOCK_BB_HEIGHT * (outerHeight - 1)}); // outer bottom wall
@@ -1727,31 +1661,8 @@ void WorldSystem::next_wave() {
 		// cover floor background in non playable area
 		// inner area
 		createBlackRectangle({WALL_BLOCK_BB_WIDTH * (outerWidth/2), WALL_BLOCK_BB_HEIGHT * (outerHeight/2)}, {WALL_BLOCK_BB_WIDTH * (innerWidth - 2), WALL_BLOCK_BB_HEIGHT * (innerHeight - 2)});
-		// outside outer to the right
-		if (outerWidth < 80) {
-			createBlackRectangle({1920 - ((80 - outerWidth)/2) * WALL_BLOCK_BB_WIDTH, 480}, {(80 - outerWidth) * WALL_BLOCK_BB_WIDTH, 960});
-		}
-		// outside outer below
-		if (outerHeight < 40) {
-			createBlackRectangle({WALL_BLOCK_BB_WIDTH * outerWidth/2, 960 - ((40 - outerHeight)/2) * WALL_BLOCK_BB_HEIGHT}, {WALL_BLOCK_BB_WIDTH * outerWidth, WALL_BLOCK_BB_HEIGHT * (40 - outerHeight)});
-		}
+		cover_outside_room(outerWidth, outerHeight);
 
-		// make right bar outside of donut unspawnable
-		if (outerWidth < 80) {
-			for (int j = 0; j < 80; j++) {
-				for (int i = outerWidth * 2; i < 160; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
-		// make below donut unspawnable
-		if (outerHeight < 40) {
-			for (int j = outerHeight * 2; j < 80; j++) {
-				for (int i = 0; i < outerWidth * 2; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
 		// make inside of inner donut unspawnable
 		for (int j = (outerHeight - innerHeight) + 2; j < (outerHeight - innerHeight) + 2 + (innerHeight - 2) * 2; j++) {
 			for (int i = (outerWidth - innerWidth) + 2; i < (outerWidth - innerWidth) + 2 + (innerWidth - 2) * 2; i++) {
@@ -1777,6 +1688,7 @@ void WorldSystem::next_wave() {
 		max_slots_count = floor(outerHeight/15);
 
 		std::cout << "U dimensions. outer w/h, inner w/h: " << outerWidth << '/' << outerHeight << ':' << innerWidth << "/" << innerHeight << std::endl;
+		layout_room(outerWidth, outerHeight);
 		// walls outer
 		for (int i = 0; i < outerWidth; i++) {
 			if (i < outerWidth/2 - innerWidth/2 || i >= outerWidth - (outerWidth/2 - innerWidth/2)) {
@@ -1800,31 +1712,8 @@ void WorldSystem::next_wave() {
 		// cover floor background in non playable area
 		// inner area
 		createBlackRectangle({WALL_BLOCK_BB_WIDTH * (outerWidth/2), WALL_BLOCK_BB_HEIGHT * (innerHeight/2)}, {WALL_BLOCK_BB_WIDTH * (innerWidth - 2), WALL_BLOCK_BB_HEIGHT * (innerHeight)});
-		// outside outer to the right
-		if (outerWidth < 80) {
-			createBlackRectangle({1920 - ((80 - outerWidth)/2) * WALL_BLOCK_BB_WIDTH, 480}, {(80 - outerWidth) * WALL_BLOCK_BB_WIDTH, 960});
-		}
-		// outside outer below
-		if (outerHeight < 40) {
-			createBlackRectangle({WALL_BLOCK_BB_WIDTH * outerWidth/2, 960 - ((40 - outerHeight)/2) * WALL_BLOCK_BB_HEIGHT}, {WALL_BLOCK_BB_WIDTH * outerWidth, WALL_BLOCK_BB_HEIGHT * (40 - outerHeight)});
-		}
+		cover_outside_room(outerWidth, outerHeight);
 
-		// make right bar outside of U unspawnable
-		if (outerWidth < 80) {
-			for (int j = 0; j < 80; j++) {
-				for (int i = outerWidth * 2; i < 160; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
-		// make below U unspawnable
-		if (outerHeight < 40) {
-			for (int j = outerHeight * 2; j < 80; j++) {
-				for (int i = 0; i < outerWidth * 2; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
 		// make inside of inner U unspawnable
 		for (int j = 0; j < innerHeight * 2; j++) {
 			for (int i = (outerWidth - innerWidth) + 2; i < (outerWidth - innerWidth) + 2 + (innerWidth - 2) * 2; i++) {
@@ -1850,6 +1739,7 @@ void WorldSystem::next_wave() {
 		max_slots_count = floor(outerHeight/15);
 
 		std::cout << "backward C dimensions. outer w/h, inner w/h: " << outerWidth << '/' << outerHeight << ':' << innerWidth << "/" << innerHeight << std::endl;
+		layout_room(outerWidth, outerHeight);
 		// walls outer
 		for (int i = 0; i < outerWidth; i++) {
 			createWallBlock(renderer, {12 + i * WALL_BLOCK_BB_WIDTH, 12}); // outer top wall
@@ -1873,31 +1763,8 @@ void WorldSystem::next_wave() {
 		// cover floor background in non playable area
 		// inner area
 		createBlackRectangle({WALL_BLOCK_BB_WIDTH * (innerWidth/2), WALL_BLOCK_BB_HEIGHT * (outerHeight/2)}, {WALL_BLOCK_BB_WIDTH * (innerWidth), WALL_BLOCK_BB_HEIGHT * (innerHeight - 2)});
-		// outside outer to the right
-		if (outerWidth < 80) {
-			createBlackRectangle({1920 - ((80 - outerWidth)/2) * WALL_BLOCK_BB_WIDTH, 480}, {(80 - outerWidth) * WALL_BLOCK_BB_WIDTH, 960});
-		}
-		// outside outer below
-		if (outerHeight < 40) {
-			createBlackRectangle({WALL_BLOCK_BB_WIDTH * outerWidth/2, 960 - ((40 - outerHeight)/2) * WALL_BLOCK_BB_HEIGHT}, {WALL_BLOCK_BB_WIDTH * outerWidth, WALL_BLOCK_BB_HEIGHT * (40 - outerHeight)});
-		}
+		cover_outside_room(outerWidth, outerHeight);
 
-		// make right bar outside of backwards C unspawnable
-		if (outerWidth < 80) {
-			for (int j = 0; j < 80; j++) {
-				for (int i = outerWidth * 2; i < 160; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
-		// make below backwards C unspawnable
-		if (outerHeight < 40) {
-			for (int j = outerHeight * 2; j < 80; j++) {
-				for (int i = 0; i < outerWidth * 2; i++) {
-					grid[j][i] = 1;
-				}
-			}
-		}
 		// make inside of backwards C unspawnable
 		for (int j = (outerHeight - innerHeight) + 2; j < (outerHeight - innerHeight) + 2 + (innerHeight - 2) * 2; j++) {
 			for (int i = 0; i < innerWidth * 2; i++) {
@@ -1908,6 +1775,9 @@ void WorldSystem::next_wave() {
 		// move player to starting location
 		player_motion.position = vec2(WALL_BLOCK_BB_WIDTH * outerWidth / 2, 84);
 	}
+	// the inside of donut and backward C rooms is left with walls only
+	level.release_solid_chunks();
+	registry.motions.mark_modified(player_protagonist);
 
 	// spawn slot machines
 	for (int num_slots = 0; num_slots < max_slots_count; num_slots++) {
@@ -1932,19 +1802,8 @@ void WorldSystem::next_wave() {
 			int grid_x = static_cast<int>(spawnX / 12);
 			int grid_y = static_cast<int>(spawnY / 12);
 
-			for (int dy = -11; dy <= 10 && valid_spawn; dy++) {
-				for (int dx = -8; dx <= 7 && valid_spawn; dx++) {
-
-					int check_x = grid_x + dx;
-					int check_y = grid_y + dy;
-					if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-						if (grid[check_y][check_x] == 1) {
-							valid_spawn = false;
-						}
-					} else {
-						valid_spawn = false;
-					}
-				}
+			if (!grid.inside(grid_y - 11, grid_x - 8) || !grid.inside(grid_y + 10, grid_x + 7) || grid.any_in_rect(grid_y - 11, grid_x - 8, grid_y + 10, grid_x + 7, CELLS_WALL)) {
+				valid_spawn = false;
 			}
 		} while (!valid_spawn);
 		// need to make sure the position is aligned with grid to avoid weird collision...
@@ -1973,19 +1832,8 @@ void WorldSystem::next_wave() {
 			// ensure table space is not occupied
 			int grid_x = static_cast<int>(spawnX / 12);
 			int grid_y = static_cast<int>(spawnY / 12);
-			for (int dy = -12; dy <= 11 && valid_spawn; dy++) {
-				for (int dx = -12; dx <= 11 && valid_spawn; dx++) {
-
-					int check_x = grid_x + dx;
-					int check_y = grid_y + dy;
-					if (check_x >= 0 && check_x < GRID_WIDTH && check_y >= 0 && check_y < GRID_HEIGHT) {
-						if (grid[check_y][check_x] == 1) {
-							valid_spawn = false;
-						}
-					} else {
-						valid_spawn = false;
-					}
-				}
+			if (!grid.inside(grid_y - 12, grid_x - 12) || !grid.inside(grid_y + 11, grid_x + 11) || grid.any_in_rect(grid_y - 12, grid_x - 12, grid_y + 11, grid_x + 11, CELLS_WALL)) {
+				valid_spawn = false;
 			}
 		} while (!valid_spawn);
 		// need to make sure the position is aligned with grid to avoid weird collision...
@@ -2003,19 +1851,23 @@ void WorldSystem::handle_collisions() {
 	// Loop over all collisions detected by the physics system
 	Wave& wave = registry.waves.get(global_wave);
 	Player& your = registry.players.get(player_protagonist);
-	auto& collisionsRegistry = registry.collisions;
-	for (uint i = 0; i < collisionsRegistry.components.size(); i++) {
-		// The entity and its collider
-		Entity entity = collisionsRegistry.entities[i];
-		Entity entity_other = collisionsRegistry.components[i].other;
+	for (size_t i = 0; i < 2 * contacts.size(); i++) {
+		// The entity and its collider, every contact is handled from both sides, first (a, b) then (b, a)
+		const Contact& contact = contacts[i / 2];
+		Entity entity = i % 2 == 0 ? contact.a : contact.b;
+		Entity entity_other = i % 2 == 0 ? contact.b : contact.a;
+
+		// Destruction is deferred until all collisions are handled, skip entities that are already gone
+		if (registry.commands.destroying(entity) || registry.commands.destroying(entity_other))
+			continue;
 
 		// player collisions
 		if (registry.players.has(entity)) {
 			Player& your = registry.players.get(entity);
-			Motion& your_motion = registry.motions.get(entity);
+			MotionRef your_motion = registry.motions.get(entity);
 			// Checking Player - Deadly collisions
 			if (registry.deadlys.has(entity_other)) {
-				Motion& deadly_motion = registry.motions.get(entity_other);
+				MotionRef deadly_motion = registry.motions.get(entity_other);
 				if (!registry.deathTimers.has(player_protagonist)) {
 					your.health -= 1;
 					vec2 push = normalize(your_motion.position - deadly_motion.position);
@@ -2062,7 +1914,7 @@ void WorldSystem::handle_collisions() {
 					LightUp& lightUp = registry.lightUp.get(entity);
 					lightUp.duration_ms = 1000.f;
 				}
-				registry.remove_all_components_of(entity_other);
+				registry.commands.destroy(entity_other);
 
 				if (your.health <= 0) {
 					if (!registry.deathTimers.has(entity)) {
@@ -2095,7 +1947,7 @@ void WorldSystem::handle_collisions() {
 					renderer->updateCoinNum(std::to_string(coins));
 
 					// chew, count coins, and set the LightUp timer
-					registry.remove_all_components_of(entity_other);
+					registry.commands.destroy(entity_other);
 					Mix_PlayChannel(3, m3_sfx_coin, 0);
 				}
 			}
@@ -2115,15 +1967,15 @@ void WorldSystem::handle_collisions() {
 			KillsEnemy& kills = registry.killsEnemys.get(entity);
 			if (registry.deadlys.has(entity_other)) {
 				Deadly& deadly = registry.deadlys.get(entity_other);
-				if (kills.last_touched != &deadly) {
+				if (kills.last_touched != entity_other) {
 					deadly.health -= (kills.damage * calculateDamageMultiplier() - deadly.armour);
-					kills.last_touched = &deadly;
+					kills.last_touched = entity_other;
 
 					if (kills.type == PROJECTILE::DART_PROJECTILE) {
-						registry.remove_all_components_of(entity);
+						registry.commands.destroy(entity);
 					} else if (kills.type == PROJECTILE::CARD_PROJECTILE) {
 						if (kills.pierce_left <= 0) {
-							registry.remove_all_components_of(entity);
+							registry.commands.destroy(entity);
 						} else {
 							kills.pierce_left -= 1;
 						}
@@ -2132,11 +1984,11 @@ void WorldSystem::handle_collisions() {
 						// where if it hits two wall blocks at once, cant control which collision to handle first
 						// and it may not bounce as it forces it to push up into second block instead of out.
 						if (kills.bounce_left <= 0) {
-							registry.remove_all_components_of(entity);
+							registry.commands.destroy(entity);
 						} else {
 							kills.bounce_left -= 1;
-							Motion& kills_motion = registry.motions.get(entity);
-							Motion& deadly_motion = registry.motions.get(entity_other);
+							MotionRef kills_motion = registry.motions.get(entity);
+							MotionRef deadly_motion = registry.motions.get(entity_other);
 							if (deadly.enemy_type == ENEMIES::KING_CLUBS) {
 								unsigned int dist_from_top = abs((deadly_motion.position.y - deadly_motion.scale.y/2) - kills_motion.position.y);
 								unsigned int dist_from_bottom = abs((deadly_motion.position.y + deadly_motion.scale.y/2) - kills_motion.position.y);
@@ -2188,7 +2040,7 @@ void WorldSystem::handle_collisions() {
 							luck -= dice_roll;
 						}
 						
-						registry.remove_all_components_of(entity_other);
+						registry.commands.destroy(entity_other);
 					}
 					Mix_PlayChannel(9, roulette_hit_sound, 0);
 				}
@@ -2196,15 +2048,14 @@ void WorldSystem::handle_collisions() {
 
 			// collision between projectile and wall
 			if (registry.solids.has(entity_other)) {
-				Solid& solid = registry.solids.get(entity_other);
-				if (kills.last_touched != &solid) {
-					kills.last_touched = &solid;
+				if (kills.last_touched != entity_other) {
+					kills.last_touched = entity_other;
 					 if (kills.type == PROJECTILE::CARD_PROJECTILE) {
-						registry.remove_all_components_of(entity);
+						registry.commands.destroy(entity);
 					} else if (kills.type == PROJECTILE::DART_PROJECTILE) {
-						registry.remove_all_components_of(entity);
+						registry.commands.destroy(entity);
 					} else if (kills.type == PROJECTILE::DIAMOND_STAR_PROJECTILE) {
-						registry.remove_all_components_of(entity);
+						registry.commands.destroy(entity);
 					}
 				}
 			}
@@ -2216,13 +2067,13 @@ void WorldSystem::handle_collisions() {
 				Deadly& deadly = registry.deadlys.get(entity_other);
 				if (deadly.enemy_type == ENEMIES::KING_CLUBS) {
 					HealsEnemy& heals = registry.healsEnemies.get(entity);
-					if (heals.last_touched != &deadly) {
+					if (heals.last_touched != entity_other) {
 						deadly.health += heals.health;
 						if (deadly.health > 50.f) {
 							deadly.health = 50.f;
 						}
-						heals.last_touched = &deadly;
-						registry.remove_all_components_of(entity);
+						heals.last_touched = entity_other;
+						registry.commands.destroy(entity);
 					}
 				}
 			}
@@ -2230,7 +2081,7 @@ void WorldSystem::handle_collisions() {
 
 		if (registry.killsEnemyLerpyDerps.has(entity)) {
 			if (registry.deadlys.has(entity_other)) {
-				registry.remove_all_components_of(entity);
+				registry.commands.destroy(entity);
 			}
 		}
 
@@ -2241,14 +2092,15 @@ void WorldSystem::handle_collisions() {
 					continue; // probably not the best thing to do but prevents genies from randomly dying if pushed into an inside corner wall
 				}
 				else {
-					registry.remove_all_components_of(entity_other);
+					registry.commands.destroy(entity_other);
 				}
 			}
 		}
 	}
 
 	// Remove all collisions from this simulation step
-	registry.collisions.clear();
+	contacts.clear();
+	registry.flush_commands();
 }
 
 // Should the game be over ?
@@ -2343,13 +2195,31 @@ bool WorldSystem::load() {
 			}
 		}
 
-		// Load solids (walls)
+		// Load level size, saves without one are from the default level
+		int level_width = DEFAULT_LEVEL_WIDTH;
+		int level_height = DEFAULT_LEVEL_HEIGHT;
+		if (j.contains("level")) {
+			level_width = j["level"]["width"];
+			level_height = j["level"]["height"];
+		}
+		level.resize(level_width, level_height);
+		// the room ends at its farthest solid, the rest of the level stays without chunks
+		int room_cols = 0;
+		int room_rows = 0;
 		if (j.contains("solids")) {
-					for (int i = 0;i<GRID_WIDTH;i++){
-			for (int j =0 ;j<GRID_HEIGHT;j++){
-				cells[j*GRID_WIDTH + i].exist = false;
+			for (auto& item : j["solids"].items()) {
+				room_cols = std::max(room_cols, (int)(item.value()["position"][0].get<float>() / TILE_SIZE) + 1);
+				room_rows = std::max(room_rows, (int)(item.value()["position"][1].get<float>() / TILE_SIZE) + 1);
 			}
 		}
+		if (room_cols == 0) {
+			room_cols = level_width;
+			room_rows = level_height;
+		}
+		level.carve(0, 0, room_rows - 1, room_cols - 1);
+
+		// Load solids (walls)
+		if (j.contains("solids")) {
 			for (auto& item : j["solids"].items()) {
 				auto& value = item.value();
 				if (value["type"] == SOLIDS::WALL) {
@@ -2517,7 +2387,7 @@ void WorldSystem::save() {
     j["enemies"] = json::object();
     for (Entity entity : registry.deadlys.entities) {
         if (registry.motions.has(entity)) {
-			Motion& motion = registry.motions.get(entity);
+			MotionRef motion = registry.motions.get(entity);
 			j["enemies"][std::to_string(entity)] = {
 				{"position", {motion.position.x, motion.position.y}},
 				{"enemy_type", registry.deadlys.get(entity).enemy_type}
@@ -2617,6 +2487,11 @@ void WorldSystem::save() {
 		{"num_bird_boss", wave.num_bird_boss}
 	};
 
+	j["level"] = {
+		{"width", level.width()},
+		{"height", level.height()}
+	};
+
 	j["solids"] = json::object();
 	for (Entity entity : registry.solids.entities) {
         // after adding solid type field, save as appropriate. For now all walls
@@ -2631,7 +2506,7 @@ void WorldSystem::save() {
 	j["floor_covers"] = json::object();
 	for (Entity entity : registry.blackRectangles.entities) {
 		if (registry.motions.has(entity)) {
-			Motion &motion = registry.motions.get(entity);
+			MotionRef motion = registry.motions.get(entity);
 			j["floor_covers"][std::to_string(entity)] = {
 				{"position", {motion.position.x, motion.position.y}},
 				{"scale", {motion.scale.x, motion.scale.y}}
@@ -2690,10 +2565,10 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	}
 	// Close game
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-		Motion* player_motion = &registry.motions.get(player_protagonist);
-		for (int i = 0; i<80;i++){
-			for (int j = 0; j<160;j++){
-				if (i==static_cast<int>(player_motion->position.y / 12)&&j==static_cast<int>(player_motion->position.x / 12)){
+		MotionRef player_motion = registry.motions.get(player_protagonist);
+		for (int i = 0; i<level.height();i++){
+			for (int j = 0; j<level.width();j++){
+				if (i==static_cast<int>(player_motion.position.y / 12)&&j==static_cast<int>(player_motion.position.x / 12)){
 				std::cout << "K";
 				}  else if (grid[i][j]==0){
 				std::cout << ".";
@@ -2715,7 +2590,7 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
 	}
 
 	
-	Motion& motion = registry.motions.get(player_protagonist);
+	MotionRef motion = registry.motions.get(player_protagonist);
 	Player& your = registry.players.get(player_protagonist);
 
 	if (action == GLFW_PRESS && key == GLFW_KEY_SPACE) {
@@ -2780,9 +2655,9 @@ void WorldSystem::on_key(int key, int, int action, int mod) {
     }
 }
 
-void WorldSystem::handle_movement() {
+void WorldSystem::handle_movement(float elapsed_ms) {
 	Wave& wave = registry.waves.get(global_wave);
-	auto& component = registry.motions.get(player_protagonist);
+	MotionRef component = registry.motions.get(player_protagonist);
 
 	if (wave.state != "game on" && wave.state != "limbo") {
 		component.velocity.x = 0.f;
@@ -2807,42 +2682,42 @@ void WorldSystem::handle_movement() {
 		} else if (up && right && down) {
 			component.velocity.x = 200.f;
 			component.velocity.y = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (up && right && left) {
 			component.velocity.y = -200.f;
 			component.velocity.x = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (up && left && down) {
 			component.velocity.x = -200.f;
 			component.velocity.y = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (down && left && right) {
 			component.velocity.y = 200.f;
 			component.velocity.x = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (up && right) {
 			component.velocity.x = cos(M_PI / 4) * 200.f;
 			component.velocity.y = -sin(M_PI / 4) * 200.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (up && left) {
 			component.velocity.x = -cos(M_PI / 4) * 200.f;
 			component.velocity.y = -sin(M_PI / 4) * 200.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
@@ -2857,42 +2732,42 @@ void WorldSystem::handle_movement() {
 		} else if (right && down) {
 			component.velocity.x = cos(M_PI / 4) * 200.f;
 			component.velocity.y = sin(M_PI / 4) * 200.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (down && left) {
 			component.velocity.x = -cos(M_PI / 4) * 200.f;
 			component.velocity.y = sin(M_PI / 4) * 200.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (up) {
 			component.velocity.y = -200.f;
 			component.velocity.x = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (down) {
 			component.velocity.y = 200.f;
 			component.velocity.x = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (right) {
 			component.velocity.x = 200.f;
 			component.velocity.y = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
 		} else if (left) {
 			component.velocity.x = -200.f;
 			component.velocity.y = 0.f;
-			texture_num += 0.05f;
+			texture_num += 0.05f * elapsed_ms / FRAME_MS;
 			if (texture_num > 2.99f) {
 				texture_num = 1.0f;
 			}
@@ -39,8 +39,8 @@ public:
 	void go_to_home(std::string* game_state);
 	std::string* game_state;
 	
-	// Handle movement
-    void handle_movement();
+	// Handle movement, the walk animation advances by the elapsed time
+    void handle_movement(float elapsed_ms);
 
 	// Should the game be over ?
 	bool is_over()const;